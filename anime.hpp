@@ -2,18 +2,23 @@
 #define ANIME_HPP
 
 #include <string>
+#include <string_view>
 #include <iostream>
 #include <functional>
 #include <vector>
+#include <cstdint>
+#include "dataStructures/genreDictionary.hpp"
+#include "dataStructures/stringArena.hpp"
 
 using namespace std;
 
 class Anime {
 public:
     int anime_id;
-    string name;
+    std::string_view name; // Guardado una sola vez en StringArena::global(), que no se libera nunca
     std::vector<std::string>  genres;
-    string type;
+    uint64_t genreMask = 0; // Bit `id` encendido por cada género (ids de GenreDictionary)
+    std::string_view type; // Etiqueta compartida en StringArena::global()
     int episodes;
     float rating;
     int members;
@@ -22,8 +27,18 @@ public:
     Anime() = default;
 
     // Constructor con parámetros
-    Anime(int id, const string& n, std::vector<std::string>& g, const string& t, int ep, float r, int m)
-        : anime_id(id), name(n), genres(g), type(t), episodes(ep), rating(r), members(m) {}
+    Anime(int id, std::string_view n, std::vector<std::string>& g, std::string_view t, int ep, float r, int m)
+        : anime_id(id), name(StringArena::global().intern(n)), genres(g), genreMask(maskOf(g)),
+          type(StringArena::global().intern(t)), episodes(ep), rating(r), members(m) {}
+
+    // Calcula la máscara de géneros internando cada nombre en el diccionario global
+    static uint64_t maskOf(const std::vector<std::string>& genres) {
+        uint64_t mask = 0;
+        for (const auto& genre : genres) {
+            mask |= uint64_t(1) << GenreDictionary::instance().intern(genre);
+        }
+        return mask;
+    }
 
     // Sobrecarga del operador < para ordenar alfabéticamente por nombre
     bool operator<(const Anime& other) const {
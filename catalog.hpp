@@ -0,0 +1,221 @@
+#ifndef CATALOG_HPP
+#define CATALOG_HPP
+
+#include "anime.hpp"
+#include "csvReader.hpp"
+#include "dataStructures/animeCatalog.hpp"
+#include "dataStructures/genreDictionary.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+/**
+ *  Everything the menu options need from anime.csv, produced by a single
+ *  scan of the file: the animes, stored column-wise in an `AnimeCatalog`,
+ *  and the list of animes of each genre.
+ *
+ *  Genres are identified by their `GenreDictionary` id, the same id used by
+ *  `Anime::genreMask`.
+ */
+struct Catalog {
+
+    AnimeCatalog animes;                                    /**< Accepted rows, in file order. */
+    std::vector<std::vector<AnimeHandle>> postings;         /**< Animes of each genre id. */
+
+    /**
+     *  Clears the catalog.
+     */
+    void clear()
+    {
+        animes.clear();
+        postings.clear();
+    }
+
+    /**
+     *  Returns the ids of the genres that have at least one anime.
+     */
+    std::vector<unsigned> genre_ids() const
+    {
+        std::vector<unsigned> ids;
+        for (unsigned genre = 0; genre < postings.size(); ++genre) {
+            if (!postings[genre].empty())
+                ids.push_back(genre);
+        }
+        return ids;
+    }
+
+    /**
+     *  Adds an anime that is already stored in `animes` to the genre lists.
+     *  The lists stay sorted by handle.
+     */
+    void index(AnimeHandle handle)
+    {
+        for (uint64_t mask = animes.genre_masks()[handle]; mask != 0; mask &= mask - 1) {
+            unsigned genre = static_cast<unsigned>(__builtin_ctzll(mask));
+            if (genre >= postings.size())
+                postings.resize(genre + 1);
+            std::vector<AnimeHandle>& posting = postings[genre];
+            if (posting.empty() || posting.back() < handle)
+                posting.push_back(handle);
+            else
+                posting.insert(std::lower_bound(posting.begin(), posting.end(), handle), handle);
+        }
+    }
+
+    /**
+     *  Removes an anime from the genre lists of its current genre mask.
+     */
+    void unindex(AnimeHandle handle)
+    {
+        for (uint64_t mask = animes.genre_masks()[handle]; mask != 0; mask &= mask - 1) {
+            std::vector<AnimeHandle>& posting = postings[__builtin_ctzll(mask)];
+            auto it = std::lower_bound(posting.begin(), posting.end(), handle);
+            if (it != posting.end() && *it == handle)
+                posting.erase(it);
+        }
+    }
+
+    /**
+     *  Appends a copy of an anime and adds it to the genre lists.
+     */
+    void add(const Anime& anime)
+    {
+        index(animes.add(anime));
+    }
+};
+
+/**
+ *  One row applied by `applyDelta`.
+ */
+struct CatalogChange {
+
+    AnimeHandle handle;         /**< The anime that was added or updated. */
+    bool added;                 /**< True for a new anime_id, false for an update. */
+    std::string_view oldName;   /**< Title before the update (empty for new rows). */
+    uint64_t oldMask;           /**< Genre mask before the update (0 for new rows). */
+};
+
+/**
+ *  Scans the valid rows of a CSV file, calling `func(record, name, genres, type)`
+ *  for each one with the unescaped title and type and the interned genre ids.
+ *  Rows for which interning or `func` throws `std::runtime_error` are reported
+ *  with `reportSkippedRow` and skipped; `func` must leave its state unchanged
+ *  when it throws.
+ *
+ *  @return False if the file could not be opened.
+ */
+template <typename Func>
+bool scanCatalog(const std::string& filename, Func func)
+{
+    MappedFile file(filename);
+    if (!file.is_open()) {
+        std::cerr << "Error al abrir el archivo: " << filename << std::endl;
+        return false;
+    }
+
+    CsvCursor cursor(file.data());
+    cursor.next_record(); // Skip header
+
+    AnimeRecord record;
+    std::vector<unsigned> genres;
+    while (!cursor.done()) {
+        if (!readAnimeRecord(cursor, record))
+            continue;
+
+        // Straight from the tokenized fields to the columns, no Anime in between.
+        // A row whose genres or type do not fit the dictionaries is reported and skipped.
+        try {
+            genres.clear();
+            forEachGenre(record.genres, [&genres](std::string_view genre) {
+                genres.push_back(GenreDictionary::instance().intern(genre));
+            });
+            std::string name, type;
+            if (record.name.escaped)
+                name = materialize(record.name);
+            if (record.type.escaped)
+                type = materialize(record.type);
+            func(record, record.name.escaped ? std::string_view(name) : record.name.text,
+                 genres, record.type.escaped ? std::string_view(type) : record.type.text);
+        } catch (const std::runtime_error& error) {
+            reportSkippedRow(record.anime_id, error);
+        }
+    }
+
+    return true;
+}
+
+/**
+ *  Builds the catalog with one scan of the CSV file.
+ *
+ *  @param[in]  filename    The CSV file.
+ *  @param[out] catalog     The catalog to fill. It is cleared first.
+ *
+ *  @return False if the file could not be opened.
+ */
+inline bool buildCatalog(const std::string& filename, Catalog& catalog)
+{
+    catalog.clear();
+
+    return scanCatalog(filename, [&catalog](const AnimeRecord& record, std::string_view name,
+                                            const std::vector<unsigned>& genres, std::string_view type) {
+        catalog.index(catalog.animes.add(record.anime_id, name, genres, type,
+                                         record.episodes, record.rating, record.members));
+    });
+}
+
+/**
+ *  Applies a delta CSV file (same columns as anime.csv) to the catalog.
+ *
+ *  Rows whose anime_id is already in the catalog replace that anime in place;
+ *  the other rows are appended in file order. The result is the catalog that
+ *  `buildCatalog` would produce for the base file with the changed rows
+ *  replaced and the new rows appended at the end. The cost depends on the
+ *  size of the delta, plus one pass over the id column.
+ *
+ *  @param[in]      deltaFile   The CSV file with the new or changed rows.
+ *  @param[in,out]  catalog     The catalog to update.
+ *
+ *  @return The applied rows, in file order, so that the structures built
+ *          from the catalog can be updated too. Empty if the file could
+ *          not be opened.
+ */
+inline std::vector<CatalogChange> applyDelta(const std::string& deltaFile, Catalog& catalog)
+{
+    AnimeCatalog& animes = catalog.animes;
+
+    std::unordered_map<int, AnimeHandle> handles;
+    handles.reserve(animes.size());
+    for (AnimeHandle handle = 0; handle < animes.size(); ++handle)
+        handles.emplace(animes.ids()[handle], handle);
+
+    std::vector<CatalogChange> changes;
+    scanCatalog(deltaFile, [&](const AnimeRecord& record, std::string_view name,
+                               const std::vector<unsigned>& genres, std::string_view type) {
+        auto it = handles.find(record.anime_id);
+        if (it == handles.end()) {
+            AnimeHandle handle = animes.add(record.anime_id, name, genres, type,
+                                            record.episodes, record.rating, record.members);
+            catalog.index(handle);
+            handles.emplace(record.anime_id, handle);
+            changes.push_back({ handle, true, std::string_view(), 0 });
+            return;
+        }
+
+        // Interning the type first means a row whose type does not fit throws before anything changes
+        AnimeHandle handle = it->second;
+        animes.intern_type(type);
+        changes.push_back({ handle, false, animes.names()[handle], animes.genre_masks()[handle] });
+        catalog.unindex(handle);
+        animes.update(handle, record.anime_id, name, genres, type, record.episodes, record.rating, record.members);
+        catalog.index(handle);
+    });
+
+    return changes;
+}
+
+#endif // CATALOG_HPP
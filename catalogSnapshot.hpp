@@ -0,0 +1,369 @@
+#ifndef CATALOG_SNAPSHOT_HPP
+#define CATALOG_SNAPSHOT_HPP
+
+#include "anime.hpp"
+#include "catalog.hpp"
+#include "csvReader.hpp"
+#include "dataStructures/animeCatalog.hpp"
+#include "dataStructures/genreDictionary.hpp"
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <sys/stat.h>
+
+/**
+ *  Binary columnar snapshot of the catalog (`catalog.bin`).
+ *
+ *  Layout: a fixed header followed by 8-byte aligned sections, one per
+ *  column. Names, genre names and type names are stored as an offsets
+ *  column (count + 1 entries) plus one blob, and the genres of each anime as
+ *  a list of genre ids. The file is used in place through `mmap`, so opening
+ *  a snapshot does no per-record work besides the checksum.
+ *
+ *  A snapshot is rejected if the magic, version or checksum do not match,
+ *  or if it was built from a CSV whose size or modification time differ from
+ *  the current one.
+ */
+class CatalogSnapshot {
+public:
+
+    static constexpr uint32_t VERSION = 1;    /**< Layout version; bumped when the layout of a released version changes. */
+
+    /**
+     *  Lays out a catalog as a snapshot image. The image only holds offsets,
+     *  so it can be used at any address (a file, a shared memory segment).
+     *
+     *  @param[in]  catalog     The catalog, as produced by `buildCatalog`.
+     *  @param[in]  source      The CSV the catalog was read from.
+     *
+     *  @return The image, or an empty vector if the catalog does not fit the
+     *          layout.
+     */
+    static std::vector<char> serialize(const Catalog& catalog, const std::string& source)
+    {
+        const GenreDictionary& dictionary = GenreDictionary::instance();
+        const AnimeCatalog& animes = catalog.animes;
+        if (animes.types().size() > AnimeCatalog::MAX_TYPES) {
+            std::cerr << "Demasiados tipos para el snapshot" << std::endl;
+            return {};
+        }
+
+        Header header{};
+        std::memcpy(header.magic, MAGIC, sizeof(header.magic));
+        header.version = VERSION;
+        header.count = static_cast<uint32_t>(animes.size());
+        header.genreCount = dictionary.size();
+        header.typeCount = static_cast<uint32_t>(animes.types().size());
+        sourceStamp(source, header.sourceSize, header.sourceTime);
+
+        // Most columns are written as they are; only strings need a blob
+        std::vector<uint32_t> nameOffsets{0}, genreNameOffsets{0}, typeNameOffsets{0};
+        std::string nameBlob, genreBlob, typeBlob;
+        for (const auto& name : animes.names()) {
+            nameBlob += name;
+            nameOffsets.push_back(static_cast<uint32_t>(nameBlob.size()));
+        }
+        for (unsigned genre = 0; genre < header.genreCount; ++genre) {
+            genreBlob += dictionary.name(genre);
+            genreNameOffsets.push_back(static_cast<uint32_t>(genreBlob.size()));
+        }
+        for (const auto& type : animes.types()) {
+            typeBlob += type;
+            typeNameOffsets.push_back(static_cast<uint32_t>(typeBlob.size()));
+        }
+
+        // Lay out the sections after the header
+        std::vector<char> file(sizeof(Header));
+        auto append = [&file, &header](Section section, const void* data, size_t bytes) {
+            file.resize((file.size() + 7) & ~size_t(7), 0);
+            header.sections[section] = file.size();
+            const char* begin = static_cast<const char*>(data);
+            file.insert(file.end(), begin, begin + bytes);
+        };
+        append(IDS, animes.ids().data(), animes.size() * sizeof(int32_t));
+        append(NAME_OFFSETS, nameOffsets.data(), nameOffsets.size() * sizeof(uint32_t));
+        append(NAME_BLOB, nameBlob.data(), nameBlob.size());
+        append(GENRE_OFFSETS, animes.genre_offsets().data(), animes.genre_offsets().size() * sizeof(uint32_t));
+        append(GENRE_LIST, animes.genre_list().data(), animes.genre_list().size());
+        append(TYPES, animes.type_ids().data(), animes.size());
+        append(EPISODES, animes.episodes().data(), animes.size() * sizeof(int32_t));
+        append(RATING, animes.ratings().data(), animes.size() * sizeof(float));
+        append(MEMBERS, animes.members().data(), animes.size() * sizeof(int32_t));
+        append(GENRE_NAME_OFFSETS, genreNameOffsets.data(), genreNameOffsets.size() * sizeof(uint32_t));
+        append(GENRE_NAME_BLOB, genreBlob.data(), genreBlob.size());
+        append(TYPE_NAME_OFFSETS, typeNameOffsets.data(), typeNameOffsets.size() * sizeof(uint32_t));
+        append(TYPE_NAME_BLOB, typeBlob.data(), typeBlob.size());
+
+        header.fileSize = file.size();
+        header.checksum = checksum(file.data() + sizeof(Header), file.size() - sizeof(Header));
+        std::memcpy(file.data(), &header, sizeof(Header));
+        return file;
+    }
+
+    /**
+     *  Writes a catalog to disk as a snapshot. The file is written under a
+     *  temporary name and renamed, so readers never see a partial snapshot.
+     *
+     *  @param[in]  filename    The snapshot path.
+     *  @param[in]  catalog     The catalog, as produced by `buildCatalog`.
+     *  @param[in]  source      The CSV the catalog was read from.
+     *
+     *  @return True if the snapshot was written.
+     */
+    static bool write(const std::string& filename, const Catalog& catalog, const std::string& source)
+    {
+        std::vector<char> file = serialize(catalog, source);
+        if (file.empty())
+            return false;
+
+        std::string temporary = filename + ".tmp";
+        {
+            std::ofstream out(temporary, std::ios::binary | std::ios::trunc);
+            if (!out.write(file.data(), file.size())) {
+                std::cerr << "Error al escribir el archivo: " << temporary << std::endl;
+                return false;
+            }
+        }
+        return std::rename(temporary.c_str(), filename.c_str()) == 0;
+    }
+
+    /**
+     *  Maps a snapshot and validates it against its source CSV.
+     *
+     *  @param[in]  filename    The snapshot path.
+     *  @param[in]  source      The CSV the snapshot must have been built from.
+     *
+     *  @return True if the snapshot is usable, false if it is missing,
+     *          corrupt, from another version or stale.
+     */
+    bool open(const std::string& filename, const std::string& source)
+    {
+        file_ = std::make_unique<MappedFile>(filename);
+        if (!file_->is_open() || !view(file_->data()))
+            return false;
+
+        if (!built_from(source)
+            || header_->checksum != checksum(data_.data() + sizeof(Header), data_.size() - sizeof(Header))) {
+            header_ = nullptr;
+            return false;
+        }
+        return true;
+    }
+
+    /**
+     *  Checks if the snapshot was built from the current contents of a CSV,
+     *  by its size and modification time.
+     *
+     *  @param[in]  source  The CSV file.
+     */
+    bool built_from(const std::string& source) const
+    {
+        uint64_t sourceSize = 0;
+        int64_t sourceTime = 0;
+        sourceStamp(source, sourceSize, sourceTime);
+        return header_ && header_->sourceSize == sourceSize && header_->sourceTime == sourceTime;
+    }
+
+    /**
+     *  Reads a snapshot image that is already in memory, e.g. a section of a
+     *  shared memory segment. Only the header is checked, so this is O(1);
+     *  the memory must outlive the object and must not change.
+     *
+     *  @param[in]  data    The image, as produced by `serialize`.
+     *
+     *  @return True if the image has the right magic, version and size.
+     */
+    bool view(std::string_view data)
+    {
+        header_ = nullptr;
+        data_ = data;
+        if (data.size() < sizeof(Header))
+            return false;
+
+        const Header* header = reinterpret_cast<const Header*>(data.data());
+        if (std::memcmp(header->magic, MAGIC, sizeof(header->magic)) != 0 || header->version != VERSION
+            || header->fileSize != data.size())
+            return false;
+
+        header_ = header;
+        return true;
+    }
+
+    /**
+     *  Returns the number of animes in the snapshot.
+     */
+    size_t size() const
+    {
+        return header_ ? header_->count : 0;
+    }
+
+    int anime_id(size_t i) const { return column<int32_t>(IDS)[i]; }
+    int episodes(size_t i) const { return column<int32_t>(EPISODES)[i]; }
+    float rating(size_t i) const { return column<float>(RATING)[i]; }
+    int members(size_t i) const { return column<int32_t>(MEMBERS)[i]; }
+
+    /**
+     *  Returns the title of the i-th anime. The view points into the mapping.
+     */
+    std::string_view name(size_t i) const
+    {
+        return blobEntry(NAME_OFFSETS, NAME_BLOB, i);
+    }
+
+    /**
+     *  Returns the type label of the i-th anime.
+     */
+    std::string_view type(size_t i) const
+    {
+        return blobEntry(TYPE_NAME_OFFSETS, TYPE_NAME_BLOB, column<uint8_t>(TYPES)[i]);
+    }
+
+    /**
+     *  Returns the number of genres of the i-th anime.
+     */
+    size_t genre_count(size_t i) const
+    {
+        const uint32_t* offsets = column<uint32_t>(GENRE_OFFSETS);
+        return offsets[i + 1] - offsets[i];
+    }
+
+    /**
+     *  Returns the name of the k-th genre of the i-th anime.
+     */
+    std::string_view genre(size_t i, size_t k) const
+    {
+        uint8_t id = column<uint8_t>(GENRE_LIST)[column<uint32_t>(GENRE_OFFSETS)[i] + k];
+        return blobEntry(GENRE_NAME_OFFSETS, GENRE_NAME_BLOB, id);
+    }
+
+    /**
+     *  Copies the i-th anime out of the snapshot. Like `toAnime`, only the
+     *  text columns in `columns` (a `LoadOptions::columns` mask) are read;
+     *  the others stay empty.
+     *
+     *  @throw std::runtime_error if a genre does not fit the `GenreDictionary`.
+     */
+    Anime anime(size_t i, unsigned columns = LoadOptions::ALL_COLUMNS) const
+    {
+        std::vector<std::string> genres;
+        if (columns & (1u << COL_GENRES)) {
+            genres.reserve(genre_count(i));
+            for (size_t k = 0; k < genre_count(i); ++k)
+                genres.emplace_back(genre(i, k));
+        }
+
+        return Anime(anime_id(i), (columns & (1u << COL_NAME)) ? name(i) : std::string_view(), genres,
+                     (columns & (1u << COL_TYPE)) ? type(i) : std::string_view(),
+                     episodes(i), rating(i), members(i));
+    }
+
+    /**
+     *  Rebuilds a full catalog from the snapshot. Type ids are preserved, and
+     *  so are genre ids when this is the first catalog loaded by the process.
+     *
+     *  @param[out] catalog     The catalog to fill. It is cleared first.
+     *
+     *  @throw std::runtime_error if the stored genres do not fit the
+     *         `GenreDictionary` of this process.
+     */
+    void read(Catalog& catalog) const
+    {
+        catalog.clear();
+
+        // Stored genre ids are translated to the ids of this process
+        std::vector<unsigned> genreIds;
+        for (uint32_t g = 0; g < header_->genreCount; ++g)
+            genreIds.push_back(GenreDictionary::instance().intern(blobEntry(GENRE_NAME_OFFSETS, GENRE_NAME_BLOB, g)));
+        for (uint32_t t = 0; t < header_->typeCount; ++t)
+            catalog.animes.intern_type(blobEntry(TYPE_NAME_OFFSETS, TYPE_NAME_BLOB, t));
+
+        const uint32_t* genreOffsets = column<uint32_t>(GENRE_OFFSETS);
+        const uint8_t* genreList = column<uint8_t>(GENRE_LIST);
+        std::vector<unsigned> genres;
+
+        catalog.animes.reserve(size());
+        for (size_t i = 0; i < size(); ++i) {
+            genres.clear();
+            for (uint32_t k = genreOffsets[i]; k < genreOffsets[i + 1]; ++k)
+                genres.push_back(genreIds[genreList[k]]);
+            catalog.index(catalog.animes.add(anime_id(i), name(i), genres, type(i), episodes(i), rating(i), members(i)));
+        }
+    }
+
+    /**
+     *  64-bit multiplicative hash over 8-byte words, then the tail bytes.
+     *  Also used by the other snapshot files.
+     */
+    static uint64_t checksum(const char* data, size_t size)
+    {
+        uint64_t hash = 0xcbf29ce484222325ULL;
+        size_t i = 0;
+        for (; i + 8 <= size; i += 8) {
+            uint64_t word;
+            std::memcpy(&word, data + i, sizeof(word));
+            hash = (hash ^ word) * 0x100000001b3ULL;
+            hash ^= hash >> 29;
+        }
+        for (; i < size; ++i)
+            hash = (hash ^ static_cast<unsigned char>(data[i])) * 0x100000001b3ULL;
+        return hash;
+    }
+
+private:
+
+    static constexpr char MAGIC[8] = {'A', 'N', 'I', 'C', 'A', 'T', '\0', '\0'};
+
+    enum Section {
+        IDS, NAME_OFFSETS, NAME_BLOB, GENRE_OFFSETS, GENRE_LIST, TYPES, EPISODES, RATING, MEMBERS,
+        GENRE_NAME_OFFSETS, GENRE_NAME_BLOB, TYPE_NAME_OFFSETS, TYPE_NAME_BLOB, SECTION_COUNT
+    };
+
+    struct Header {
+        char magic[8];
+        uint32_t version;
+        uint32_t count;                     /**< Number of animes. */
+        uint32_t genreCount;
+        uint32_t typeCount;
+        uint64_t sourceSize;                /**< Size of the source CSV. */
+        int64_t sourceTime;                 /**< Modification time of the source CSV (ns). */
+        uint64_t fileSize;
+        uint64_t checksum;                  /**< Checksum of everything after the header. */
+        uint64_t sections[SECTION_COUNT];   /**< File offset of each section. */
+    };
+
+    // Reads the size and modification time of a file (zero if it does not exist)
+    static void sourceStamp(const std::string& filename, uint64_t& size, int64_t& time)
+    {
+        struct stat info;
+        size = 0;
+        time = 0;
+        if (::stat(filename.c_str(), &info) == 0) {
+            size = static_cast<uint64_t>(info.st_size);
+            time = static_cast<int64_t>(info.st_mtim.tv_sec) * 1000000000 + info.st_mtim.tv_nsec;
+        }
+    }
+
+    template <typename T>
+    const T* column(Section section) const
+    {
+        return reinterpret_cast<const T*>(data_.data() + header_->sections[section]);
+    }
+
+    std::string_view blobEntry(Section offsets, Section blob, size_t i) const
+    {
+        const uint32_t* bounds = column<uint32_t>(offsets);
+        return std::string_view(column<char>(blob) + bounds[i], bounds[i + 1] - bounds[i]);
+    }
+
+    std::unique_ptr<MappedFile> file_;      /**< The mapped snapshot, if it was opened from a file. */
+    std::string_view data_;                 /**< The snapshot image. */
+    const Header* header_{nullptr};         /**< Header of a validated snapshot, null otherwise. */
+};
+
+#endif // CATALOG_SNAPSHOT_HPP
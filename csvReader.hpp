@@ -0,0 +1,625 @@
+#ifndef CSV_READER_HPP
+#define CSV_READER_HPP
+
+#include "anime.hpp"
+#include "csvScanner.hpp"
+#include <algorithm>
+#include <charconv>
+#include <cstddef>
+#include <initializer_list>
+#include <iostream>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/**
+ *  Read-only memory mapping of a whole file.
+ *
+ *  The mapping lives as long as the object, so every `std::string_view`
+ *  handed out by the tokenizer must not outlive it.
+ */
+class MappedFile {
+public:
+
+    /**
+     *  Maps the specified file. Use `is_open()` to check the result.
+     *
+     *  @param[in]  filename    The path of the file to map.
+     */
+    explicit MappedFile(const std::string& filename)
+    {
+        int fd = ::open(filename.c_str(), O_RDONLY);
+        if (fd < 0)
+            return;
+
+        struct stat info;
+        if (::fstat(fd, &info) == 0) {
+            open_ = true;
+            size_ = static_cast<size_t>(info.st_size);
+
+            if (size_ > 0) {
+                void* address = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+                if (address == MAP_FAILED) {
+                    open_ = false;
+                    size_ = 0;
+                } else {
+                    data_ = static_cast<const char*>(address);
+                    ::madvise(address, size_, MADV_SEQUENTIAL);
+                }
+            }
+        }
+
+        ::close(fd);
+    }
+
+    /**
+     *  Destructor. Unmaps the file.
+     */
+    ~MappedFile()
+    {
+        if (data_ != nullptr)
+            ::munmap(const_cast<char*>(data_), size_);
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    /**
+     *  Checks if the file could be opened and mapped.
+     */
+    bool is_open() const
+    {
+        return open_;
+    }
+
+    /**
+     *  Returns the contents of the file.
+     */
+    std::string_view data() const
+    {
+        return std::string_view(data_, size_);
+    }
+
+private:
+
+    const char* data_{nullptr};     /**< Start of the mapping (null for empty files). */
+    size_t size_{0};                /**< Size of the mapping in bytes. */
+    bool open_{false};              /**< Whether the file was opened. */
+};
+
+/**
+ *  A field returned by `CsvCursor`. The text points into the mapped file and
+ *  has the enclosing quotes already removed.
+ */
+struct CsvField {
+
+    std::string_view text;          /**< Raw field contents. */
+    bool escaped{false};            /**< True if the text still contains doubled `""` quotes. */
+};
+
+/**
+ *  One-pass RFC-4180 tokenizer over an in-memory CSV buffer.
+ *
+ *  Quoted fields may contain commas, line breaks and doubled quotes. Records
+ *  may end with `\n` or `\r\n`, and the last record may lack a terminator.
+ *
+ *  Field boundaries come from a `CsvScanner`, which finds the separators
+ *  outside quotes with SIMD instructions; the cursor just walks the offsets.
+ */
+class CsvCursor {
+public:
+
+    /**
+     *  Creates a cursor positioned at the start of the buffer.
+     *
+     *  @param[in]  text    The CSV contents.
+     *  @param[in]  level   The instruction set used to scan the buffer.
+     */
+    explicit CsvCursor(std::string_view text, CsvScanLevel level = bestCsvScanLevel())
+        : text_(text), scanner_(text, level) {}
+
+    /**
+     *  Checks if the whole buffer has been consumed.
+     */
+    bool done() const
+    {
+        return pos_ >= text_.size();
+    }
+
+    /**
+     *  Returns the offset of the next unread byte.
+     */
+    size_t position() const
+    {
+        return pos_;
+    }
+
+    /**
+     *  Checks if the cursor is at the end of the current record.
+     */
+    bool end_of_record() const
+    {
+        return atRecordEnd_;
+    }
+
+    /**
+     *  Reads the next field of the current record.
+     *
+     *  @param[out] field   The field that was read.
+     *
+     *  @return False if the current record has no more fields.
+     */
+    bool next_field(CsvField& field)
+    {
+        if (atRecordEnd_)
+            return false;
+
+        field = decode(next_raw_field());
+        return true;
+    }
+
+    /**
+     *  Reads the raw text of the next fields of the current record, quotes
+     *  included, and moves to the next record. Nothing is decoded, so this
+     *  is the cheapest way to step over a record.
+     *
+     *  @param[out] fields  Receives up to `max` raw fields.
+     *  @param[in]  max     The number of fields wanted.
+     *
+     *  @return The number of fields stored. Fields after the first `max` are skipped.
+     */
+    size_t next_raw_fields(std::string_view* fields, size_t max)
+    {
+        // Hot loop of the loaders: the state is kept in locals so the stores
+        // to `fields` do not force the members to be reloaded
+        const char* data = text_.data();
+        const size_t size = text_.size();
+        size_t pos = pos_;
+        size_t count = 0;
+        bool atEnd = atRecordEnd_;
+
+        while (!atEnd) {
+            if (next_ == window_.count) {
+                if (!scanner_.done()) {
+                    window_ = scanner_.next_window();
+                    next_ = 0;
+                    continue;
+                }
+                // Last field of the buffer
+                if (count < max)
+                    fields[count] = std::string_view(data + pos, size - pos);
+                ++count;
+                pos = size;
+                break;
+            }
+
+            size_t end = window_.base + window_.offsets[next_++];
+            if (count < max)
+                fields[count] = std::string_view(data + pos, end - pos);
+            ++count;
+
+            char separator = data[end];
+            pos = end + 1;
+            if (separator == ',')
+                continue;
+            if (separator == '\r' && pos < size && data[pos] == '\n')
+                ++pos;
+            atEnd = true;
+        }
+
+        pos_ = pos;
+        atRecordEnd_ = done();
+        return std::min(count, max);
+    }
+
+    /**
+     *  Turns a raw field returned by `next_raw_fields` into a field: the
+     *  enclosing quotes are removed and doubled quotes are flagged.
+     */
+    CsvField decode(std::string_view raw) const
+    {
+        CsvField field;
+        if (raw.empty() || raw[0] != '"') {
+            field.text = raw;
+            return field;
+        }
+
+        // Quoted field: up to the closing quote; garbage after it is ignored
+        size_t quote = std::string_view::npos;
+        if (raw.data() + raw.size() != text_.data() + text_.size() || !scanner_.unterminated_quote())
+            quote = raw.rfind('"');
+        field.text = (quote == std::string_view::npos || quote == 0) ? raw.substr(1) : raw.substr(1, quote - 1);
+        field.escaped = field.text.find('"') != std::string_view::npos;
+        return field;
+    }
+
+    /**
+     *  Skips what is left of the current record and moves to the next one.
+     */
+    void next_record()
+    {
+        while (!atRecordEnd_)
+            next_raw_field();
+        atRecordEnd_ = done();
+    }
+
+private:
+
+    // Returns the offset of the first separator at or after pos_, or the buffer size
+    size_t next_separator()
+    {
+        while (true) {
+            while (next_ < window_.count) {
+                size_t offset = window_.base + window_.offsets[next_];
+                if (offset >= pos_)
+                    return offset;
+                ++next_;
+            }
+            if (scanner_.done())
+                return text_.size();
+            window_ = scanner_.next_window();
+            next_ = 0;
+        }
+    }
+
+    // Returns the text up to the next separator and consumes the separator
+    std::string_view next_raw_field()
+    {
+        size_t end = next_separator();
+        std::string_view raw = text_.substr(pos_, end - pos_);
+        pos_ = end;
+        consume_separator();
+        return raw;
+    }
+
+    // Consumes the separator at pos_ and flags the end of the record
+    void consume_separator()
+    {
+        if (pos_ >= text_.size()) {
+            atRecordEnd_ = true;
+            return;
+        }
+
+        char separator = text_[pos_++];
+        if (separator == ',')
+            return;
+
+        if (separator == '\r' && pos_ < text_.size() && text_[pos_] == '\n')
+            ++pos_;
+        atRecordEnd_ = true;
+    }
+
+    std::string_view text_;         /**< The CSV buffer. */
+    size_t pos_{0};                 /**< Offset of the next unread byte. */
+    bool atRecordEnd_{false};       /**< Whether the current record has been fully read. */
+
+    CsvScanner scanner_;            /**< Source of the separator offsets. */
+    CsvWindow window_;              /**< Offsets of the window being consumed. */
+    size_t next_{0};                /**< Next offset of `window_` to look at. */
+};
+
+/**
+ *  Copies a field into a string, collapsing doubled quotes.
+ */
+inline std::string materialize(const CsvField& field)
+{
+    if (!field.escaped)
+        return std::string(field.text);
+
+    std::string result;
+    result.reserve(field.text.size());
+    for (size_t i = 0; i < field.text.size(); ++i) {
+        result += field.text[i];
+        if (field.text[i] == '"' && i + 1 < field.text.size() && field.text[i + 1] == '"')
+            ++i;
+    }
+    return result;
+}
+
+/**
+ *  Removes leading and trailing spaces from a view.
+ */
+inline std::string_view trimSpaces(std::string_view text)
+{
+    size_t first = text.find_first_not_of(' ');
+    if (first == std::string_view::npos)
+        return std::string_view();
+    size_t last = text.find_last_not_of(' ');
+    return text.substr(first, last - first + 1);
+}
+
+/**
+ *  Parses an integer field. Returns false if the field is not a number.
+ */
+inline bool parseField(std::string_view text, int& value)
+{
+    const char* end = text.data() + text.size();
+    auto result = std::from_chars(text.data(), end, value);
+    return result.ec == std::errc() && result.ptr != text.data();
+}
+
+/**
+ *  Parses a floating point field. Returns false if the field is not a number.
+ */
+inline bool parseField(std::string_view text, float& value)
+{
+    const char* end = text.data() + text.size();
+    auto result = std::from_chars(text.data(), end, value);
+    return result.ec == std::errc() && result.ptr != text.data();
+}
+
+/**
+ *  A row of anime.csv that has been tokenized but not yet copied. The views
+ *  point into the mapped file.
+ */
+struct AnimeRecord {
+
+    int anime_id{0};
+    CsvField name;
+    CsvField genres;
+    CsvField type;
+    int episodes{-1};
+    float rating{-1.0f};
+    int members{-1};
+};
+
+/**
+ *  Columns of anime.csv, in file order.
+ */
+enum AnimeColumn { COL_ID, COL_NAME, COL_GENRES, COL_TYPE, COL_EPISODES, COL_RATING, COL_MEMBERS, COL_COUNT };
+
+/**
+ *  Range condition on a numeric column. Both bounds are inclusive.
+ */
+struct ColumnFilter {
+
+    AnimeColumn column;
+    double min;
+    double max;
+};
+
+/**
+ *  What a loader needs from anime.csv: which columns to materialize and
+ *  which rows to keep.
+ *
+ *  Rows are still validated the same way, whatever the options, so a
+ *  projection never changes which rows are accepted.
+ */
+struct LoadOptions {
+
+    static constexpr unsigned ALL_COLUMNS = (1u << COL_COUNT) - 1;
+
+    unsigned columns{ALL_COLUMNS};          /**< Bit `1 << column` for each column to materialize. */
+    std::vector<ColumnFilter> filters;      /**< Conditions every kept row must satisfy. */
+
+    /**
+     *  Materializes only the specified columns (the numeric columns are
+     *  always parsed, since they are needed to validate the row).
+     */
+    LoadOptions& project(std::initializer_list<AnimeColumn> projection)
+    {
+        columns = 0;
+        for (AnimeColumn column : projection)
+            columns |= 1u << column;
+        return *this;
+    }
+
+    /**
+     *  Keeps only the rows whose value in a numeric column is within [min, max].
+     *
+     *  @throw std::invalid_argument if the column is not numeric.
+     */
+    LoadOptions& where(AnimeColumn column, double min, double max = std::numeric_limits<double>::infinity())
+    {
+        if (column != COL_ID && column != COL_EPISODES && column != COL_RATING && column != COL_MEMBERS)
+            throw std::invalid_argument("Only numeric columns can be filtered");
+        filters.push_back({ column, min, max });
+        return *this;
+    }
+
+    /**
+     *  Checks if a column is materialized.
+     */
+    bool has(AnimeColumn column) const
+    {
+        return (columns & (1u << column)) != 0;
+    }
+
+    /**
+     *  Checks the filters against already parsed values.
+     */
+    bool accepts(int animeId, int episodes, float rating, int members) const
+    {
+        for (const ColumnFilter& filter : filters) {
+            double value = filter.column == COL_ID ? animeId : filter.column == COL_EPISODES ? episodes
+                         : filter.column == COL_RATING ? rating : members;
+            if (value < filter.min || value > filter.max)
+                return false;
+        }
+        return true;
+    }
+};
+
+/**
+ *  Tokenizes the next row of anime.csv and checks it the same way `readCSV`
+ *  always has: rows without genres, type, episodes or rating are rejected.
+ *
+ *  The row filters are evaluated first, straight from the raw fields, so a
+ *  rejected row costs one walk over its separators and the parse of the
+ *  deciding column. Columns left out of the projection are not decoded.
+ *
+ *  The cursor is always left at the start of the following row.
+ *
+ *  @param[in,out]  cursor  The tokenizer, positioned at the start of a row.
+ *  @param[out]     record  The tokenized row.
+ *  @param[in]      options Filters and projection.
+ *
+ *  @return True if the row is valid and passes the filters.
+ */
+inline bool readAnimeRecord(CsvCursor& cursor, AnimeRecord& record, const LoadOptions& options = LoadOptions())
+{
+    std::string_view raw[COL_COUNT];
+    if (cursor.next_raw_fields(raw, COL_COUNT) < COL_COUNT)
+        return false;
+
+    for (const ColumnFilter& filter : options.filters) {
+        std::string_view text = cursor.decode(raw[filter.column]).text;
+        double value;
+        if (filter.column == COL_RATING) {
+            float rating;
+            if (!parseField(text, rating))
+                return false;
+            value = rating;
+        } else {
+            int number;
+            if (!parseField(text, number))
+                return false;
+            value = number;
+        }
+        if (value < filter.min || value > filter.max)
+            return false;
+    }
+
+    record.name = options.has(COL_NAME) ? cursor.decode(raw[COL_NAME]) : CsvField();
+    record.genres = cursor.decode(raw[COL_GENRES]);
+    record.type = cursor.decode(raw[COL_TYPE]);
+
+    return parseField(cursor.decode(raw[COL_ID]).text, record.anime_id)
+        && !record.genres.text.empty()
+        && !record.type.text.empty()
+        && parseField(cursor.decode(raw[COL_EPISODES]).text, record.episodes) && record.episodes >= 0
+        && parseField(cursor.decode(raw[COL_RATING]).text, record.rating) && record.rating >= 0
+        && parseField(cursor.decode(raw[COL_MEMBERS]).text, record.members);
+}
+
+/**
+ *  Calls a function with each genre of a genres field, trimmed of spaces.
+ */
+template <typename Func>
+void forEachGenre(const CsvField& field, Func func)
+{
+    std::string storage;
+    std::string_view genres = field.text;
+    if (field.escaped) {
+        storage = materialize(field);
+        genres = storage;
+    }
+
+    while (!genres.empty()) {
+        size_t comma = genres.find(',');
+        func(trimSpaces(genres.substr(0, comma)));
+        if (comma == std::string_view::npos)
+            break;
+        genres.remove_prefix(comma + 1);
+    }
+}
+
+/**
+ *  Reports a valid row that a loader skipped because it could not be stored,
+ *  e.g. because it brings a 65th genre (see `GenreDictionary::intern`). The
+ *  loaders catch that error per row, so the rest of the file still loads.
+ */
+inline void reportSkippedRow(int animeId, const std::exception& error)
+{
+    std::cerr << "Fila omitida (anime_id " << animeId << "): " << error.what() << std::endl;
+}
+
+/**
+ *  Copies a tokenized row into an `Anime`, splitting and trimming the genres.
+ *  Text columns left out of `columns` (a `LoadOptions::columns` mask) stay empty.
+ *
+ *  @throw std::runtime_error if a genre does not fit the `GenreDictionary`.
+ */
+inline Anime toAnime(const AnimeRecord& record, unsigned columns = LoadOptions::ALL_COLUMNS)
+{
+    std::vector<std::string> vectorGenre;
+    if (columns & (1u << COL_GENRES)) {
+        forEachGenre(record.genres, [&vectorGenre](std::string_view genre) {
+            vectorGenre.emplace_back(genre);
+        });
+    }
+
+    // Unescaped fields go straight from the mapping into the string arena
+    std::string name, type;
+    if (record.name.escaped)
+        name = materialize(record.name);
+    if (record.type.escaped)
+        type = materialize(record.type);
+    std::string_view typeText = record.type.escaped ? std::string_view(type) : record.type.text;
+
+    return Anime(record.anime_id, record.name.escaped ? std::string_view(name) : record.name.text, vectorGenre,
+                 (columns & (1u << COL_TYPE)) ? typeText : std::string_view(),
+                 record.episodes, record.rating, record.members);
+}
+
+/**
+ *  Splits a CSV buffer into contiguous byte ranges that start and end on
+ *  record boundaries, so each range can be tokenized on its own.
+ *
+ *  A boundary is only placed after a line break that is outside quotes, so
+ *  quoted fields with embedded line breaks are never split. The quote state
+ *  at the start of each range is obtained from the parity of the quotes
+ *  before it (doubled quotes count twice and do not change the parity); the
+ *  quotes are counted in parallel.
+ *
+ *  @param[in]  text    The CSV buffer, starting at the first data record.
+ *  @param[in]  parts   The desired number of ranges.
+ *
+ *  @return The range boundaries: `parts + 1` increasing offsets starting
+ *          at 0 and ending at `text.size()`. Ranges may be empty.
+ */
+inline std::vector<size_t> findRecordBoundaries(std::string_view text, unsigned parts)
+{
+    parts = std::max(1u, parts);
+    std::vector<size_t> bounds(parts + 1, text.size());
+    bounds[0] = 0;
+
+    // Count the quotes of each nominal range in parallel
+    size_t step = text.size() / parts;
+    std::vector<size_t> quotes(parts, 0);
+    std::vector<std::thread> workers;
+    for (unsigned p = 0; p < parts; ++p) {
+        workers.emplace_back([&, p]() {
+            size_t begin = p * step;
+            size_t end = (p + 1 == parts) ? text.size() : begin + step;
+            quotes[p] = std::count(text.begin() + begin, text.begin() + end, '"');
+        });
+    }
+    for (auto& worker : workers)
+        worker.join();
+
+    // Move each nominal start forward to the next line break outside quotes
+    size_t quotesBefore = 0;
+    for (unsigned p = 1; p < parts; ++p) {
+        quotesBefore += quotes[p - 1];
+        if (bounds[p - 1] >= p * step) {
+            // The previous record already runs past this nominal start
+            bounds[p] = bounds[p - 1];
+            continue;
+        }
+
+        bool inQuotes = quotesBefore % 2 == 1;
+        size_t pos = p * step;
+
+        while (pos < text.size()) {
+            if (text[pos] == '"')
+                inQuotes = !inQuotes;
+            else if (text[pos] == '\n' && !inQuotes)
+                break;
+            ++pos;
+        }
+
+        bounds[p] = std::min(pos + 1, text.size());
+    }
+
+    return bounds;
+}
+
+#endif // CSV_READER_HPP
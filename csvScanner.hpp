@@ -0,0 +1,313 @@
+#ifndef CSV_SCANNER_HPP
+#define CSV_SCANNER_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define CSV_SCANNER_X86 1
+#endif
+
+/**
+ *  Instruction sets the scanner can use, from slowest to fastest.
+ */
+enum class CsvScanLevel { Scalar, SSE2, AVX2 };
+
+/**
+ *  Returns the fastest scan level supported by the running CPU. The check is
+ *  done once.
+ */
+inline CsvScanLevel bestCsvScanLevel()
+{
+#ifdef CSV_SCANNER_X86
+    static const CsvScanLevel level = __builtin_cpu_supports("avx2") ? CsvScanLevel::AVX2 : CsvScanLevel::SSE2;
+    return level;
+#else
+    return CsvScanLevel::Scalar;
+#endif
+}
+
+namespace csv_detail {
+
+/**
+ *  Bitmasks of the interesting bytes of a 64-byte block (bit i is byte i).
+ */
+struct BlockMasks {
+
+    uint64_t quotes;        /**< `"` bytes. */
+    uint64_t separators;    /**< `,`, `\n` and `\r` bytes. */
+    uint64_t carriages;     /**< `\r` bytes. */
+    uint64_t newlines;      /**< `\n` bytes. */
+};
+
+/**
+ *  State carried from one block to the next.
+ */
+struct ScanState {
+
+    uint64_t inQuotes{0};   /**< All ones while inside a quoted field. */
+    uint64_t carriage{0};   /**< 1 if the previous block ended with `\r`. */
+};
+
+/**
+ *  Turns each set bit into a toggle: bit i of the result is the parity of
+ *  the bits 0..i of `x`. With `x` the quote mask, this marks the bytes that
+ *  are inside quotes (opening quote included, closing quote excluded).
+ */
+inline uint64_t prefixXor(uint64_t x)
+{
+    x ^= x << 1;
+    x ^= x << 2;
+    x ^= x << 4;
+    x ^= x << 8;
+    x ^= x << 16;
+    x ^= x << 32;
+    return x;
+}
+
+/**
+ *  Writes the offsets of the separators of a block that are outside quotes.
+ *  The `\n` of a `\r\n` pair is left out: the pair is a single separator.
+ *
+ *  @param[in]      masks   The classified block.
+ *  @param[in,out]  state   State at the start of the block; updated for the next block.
+ *  @param[in]      base    Offset of the block, added to each bit index.
+ *  @param[out]     out     Where the offsets are written.
+ *
+ *  @return The number of offsets written.
+ */
+inline size_t emitSeparators(const BlockMasks& masks, ScanState& state, uint32_t base, uint32_t* out)
+{
+    uint64_t quoted = prefixXor(masks.quotes) ^ state.inQuotes;
+    state.inQuotes = static_cast<uint64_t>(static_cast<int64_t>(quoted) >> 63);
+
+    uint64_t pairedNewlines = ((masks.carriages << 1) | state.carriage) & masks.newlines;
+    state.carriage = masks.carriages >> 63;
+
+    uint64_t bits = masks.separators & ~quoted & ~pairedNewlines;
+    size_t count = 0;
+    while (bits != 0) {
+        out[count++] = base + static_cast<uint32_t>(__builtin_ctzll(bits));
+        bits &= bits - 1;
+    }
+    return count;
+}
+
+/**
+ *  Returns 0x80 in each byte of `word` equal to `byte` (0x0101...01 * c),
+ *  0 elsewhere. Exact: no borrow crosses byte lanes.
+ */
+inline uint64_t matchBytes(uint64_t word, uint64_t byte)
+{
+    const uint64_t low7 = 0x7f7f7f7f7f7f7f7fULL;
+    uint64_t t = word ^ byte;
+    return ~(((t & low7) + low7) | t | low7);
+}
+
+/**
+ *  Packs the high bit of each byte of `x` into the low 8 bits.
+ */
+inline uint64_t packHighBits(uint64_t x)
+{
+    return ((x >> 7) * 0x0102040810204080ULL) >> 56;
+}
+
+inline BlockMasks classifyScalar(const char* block)
+{
+    const uint64_t ones = 0x0101010101010101ULL;
+    BlockMasks masks{0, 0, 0, 0};
+    for (unsigned k = 0; k < 8; ++k) {
+        uint64_t word;
+        std::memcpy(&word, block + k * 8, sizeof(word));
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+        word = __builtin_bswap64(word); // Byte i must be bits 8i..8i+7
+#endif
+        uint64_t carriages = matchBytes(word, ones * '\r');
+        uint64_t newlines = matchBytes(word, ones * '\n');
+        masks.quotes |= packHighBits(matchBytes(word, ones * '"')) << (k * 8);
+        masks.separators |= packHighBits(matchBytes(word, ones * ',') | carriages | newlines) << (k * 8);
+        masks.carriages |= packHighBits(carriages) << (k * 8);
+        masks.newlines |= packHighBits(newlines) << (k * 8);
+    }
+    return masks;
+}
+
+inline size_t scanScalar(const char* data, size_t blocks, ScanState& state, uint32_t* out)
+{
+    size_t count = 0;
+    for (size_t b = 0; b < blocks; ++b)
+        count += emitSeparators(classifyScalar(data + b * 64), state, static_cast<uint32_t>(b * 64), out + count);
+    return count;
+}
+
+#ifdef CSV_SCANNER_X86
+
+inline size_t scanSSE2(const char* data, size_t blocks, ScanState& state, uint32_t* out)
+{
+    const __m128i quote = _mm_set1_epi8('"');
+    const __m128i comma = _mm_set1_epi8(',');
+    const __m128i newline = _mm_set1_epi8('\n');
+    const __m128i carriage = _mm_set1_epi8('\r');
+
+    size_t count = 0;
+    for (size_t b = 0; b < blocks; ++b) {
+        BlockMasks masks{0, 0, 0, 0};
+        for (unsigned k = 0; k < 4; ++k) {
+            __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + b * 64 + k * 16));
+            __m128i carriages = _mm_cmpeq_epi8(bytes, carriage);
+            __m128i newlines = _mm_cmpeq_epi8(bytes, newline);
+            __m128i separators = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(bytes, comma), newlines), carriages);
+            masks.quotes |= uint64_t(static_cast<uint16_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(bytes, quote)))) << (k * 16);
+            masks.separators |= uint64_t(static_cast<uint16_t>(_mm_movemask_epi8(separators))) << (k * 16);
+            masks.carriages |= uint64_t(static_cast<uint16_t>(_mm_movemask_epi8(carriages))) << (k * 16);
+            masks.newlines |= uint64_t(static_cast<uint16_t>(_mm_movemask_epi8(newlines))) << (k * 16);
+        }
+        count += emitSeparators(masks, state, static_cast<uint32_t>(b * 64), out + count);
+    }
+    return count;
+}
+
+__attribute__((target("avx2")))
+inline size_t scanAVX2(const char* data, size_t blocks, ScanState& state, uint32_t* out)
+{
+    const __m256i quote = _mm256_set1_epi8('"');
+    const __m256i comma = _mm256_set1_epi8(',');
+    const __m256i newline = _mm256_set1_epi8('\n');
+    const __m256i carriage = _mm256_set1_epi8('\r');
+
+    size_t count = 0;
+    for (size_t b = 0; b < blocks; ++b) {
+        BlockMasks masks{0, 0, 0, 0};
+        for (unsigned k = 0; k < 2; ++k) {
+            __m256i bytes = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + b * 64 + k * 32));
+            __m256i carriages = _mm256_cmpeq_epi8(bytes, carriage);
+            __m256i newlines = _mm256_cmpeq_epi8(bytes, newline);
+            __m256i separators = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(bytes, comma), newlines), carriages);
+            masks.quotes |= uint64_t(static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(bytes, quote)))) << (k * 32);
+            masks.separators |= uint64_t(static_cast<uint32_t>(_mm256_movemask_epi8(separators))) << (k * 32);
+            masks.carriages |= uint64_t(static_cast<uint32_t>(_mm256_movemask_epi8(carriages))) << (k * 32);
+            masks.newlines |= uint64_t(static_cast<uint32_t>(_mm256_movemask_epi8(newlines))) << (k * 32);
+        }
+        count += emitSeparators(masks, state, static_cast<uint32_t>(b * 64), out + count);
+    }
+    return count;
+}
+
+#endif // CSV_SCANNER_X86
+
+} // namespace csv_detail
+
+/**
+ *  Separator offsets found in one window of the buffer.
+ */
+struct CsvWindow {
+
+    size_t base{0};                     /**< Offset of the window in the buffer. */
+    const uint32_t* offsets{nullptr};   /**< Separator offsets relative to `base`, increasing. */
+    size_t count{0};                    /**< Number of offsets. */
+};
+
+/**
+ *  Vectorized structural scanner for CSV buffers.
+ *
+ *  The buffer is classified 64 bytes at a time into quote and separator
+ *  (`,`, `\n`, `\r`) bitmasks; a prefix XOR of the quote mask gives the
+ *  bytes that are inside quoted fields, and the separators outside quotes
+ *  are written out as field boundary offsets. Doubled quotes toggle the
+ *  state twice, so they need no special handling, and a `\r\n` pair gives
+ *  a single offset (the `\r`).
+ *
+ *  The offsets are produced one window at a time into a reusable buffer,
+ *  so memory use does not grow with the file. Quotes are only meaningful at
+ *  the start of a field (RFC 4180); a stray quote in the middle of an
+ *  unquoted field is treated as opening a quoted section.
+ */
+class CsvScanner {
+public:
+
+    static constexpr size_t WINDOW = 16 * 1024;    /**< Bytes scanned per call to `next_window` (multiple of 64). */
+
+    /**
+     *  Creates a scanner positioned at the start of the buffer.
+     *
+     *  @param[in]  text    The CSV contents.
+     *  @param[in]  level   The instruction set to use.
+     */
+    explicit CsvScanner(std::string_view text, CsvScanLevel level = bestCsvScanLevel())
+        : text_(text), level_(level), offsets_(WINDOW) {}
+
+    /**
+     *  Checks if the whole buffer has been scanned.
+     */
+    bool done() const
+    {
+        return scanned_ >= text_.size();
+    }
+
+    /**
+     *  Checks if the buffer ends inside an unterminated quoted field. Only
+     *  meaningful once `done()` is true.
+     */
+    bool unterminated_quote() const
+    {
+        return state_.inQuotes != 0;
+    }
+
+    /**
+     *  Scans the next window of the buffer.
+     *
+     *  @return The separators outside quotes found in the window. The
+     *          offsets are valid until the next call.
+     */
+    CsvWindow next_window()
+    {
+        size_t base = scanned_;
+        size_t length = std::min(WINDOW, text_.size() - base);
+        size_t blocks = length / 64;
+
+        size_t count = scan(text_.data() + base, blocks, offsets_.data());
+
+        if (length % 64 != 0) {
+            // Pad the last partial block with spaces, which are never structural
+            char tail[64];
+            std::memset(tail, ' ', sizeof(tail));
+            std::memcpy(tail, text_.data() + base + blocks * 64, length % 64);
+            size_t extra = scan(tail, 1, offsets_.data() + count);
+            for (size_t i = count; i < count + extra; ++i)
+                offsets_[i] += static_cast<uint32_t>(blocks * 64);
+            count += extra;
+        }
+
+        scanned_ = base + length;
+        return { base, offsets_.data(), count };
+    }
+
+private:
+
+    size_t scan(const char* data, size_t blocks, uint32_t* out)
+    {
+        switch (level_) {
+#ifdef CSV_SCANNER_X86
+            case CsvScanLevel::AVX2:
+                return csv_detail::scanAVX2(data, blocks, state_, out);
+            case CsvScanLevel::SSE2:
+                return csv_detail::scanSSE2(data, blocks, state_, out);
+#endif
+            default:
+                return csv_detail::scanScalar(data, blocks, state_, out);
+        }
+    }
+
+    std::string_view text_;             /**< The CSV buffer. */
+    CsvScanLevel level_;                /**< Instruction set in use. */
+    size_t scanned_{0};                 /**< Offset of the first byte not yet scanned. */
+    csv_detail::ScanState state_;       /**< Quote and `\r` state at the end of the scanned bytes. */
+    std::vector<uint32_t> offsets_;     /**< Separator offsets of the current window. */
+};
+
+#endif // CSV_SCANNER_HPP
@@ -0,0 +1,342 @@
+#ifndef ANIME_CATALOG_HPP
+#define ANIME_CATALOG_HPP
+
+#include "../anime.hpp"
+#include "genreDictionary.hpp"
+#include "stringArena.hpp"
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+/**
+ *  Dense index of an anime inside an `AnimeCatalog`.
+ */
+using AnimeHandle = uint32_t;
+
+class AnimeCatalog;
+
+/**
+ *  Lightweight object-like view of one anime stored in an `AnimeCatalog`.
+ *
+ *  It is just a catalog pointer and a handle; every accessor reads the
+ *  matching column. It stays valid while the catalog is alive and not cleared.
+ */
+class AnimeRef {
+public:
+
+    AnimeRef(const AnimeCatalog& catalog, AnimeHandle handle) : catalog_(&catalog), handle_(handle) {}
+
+    AnimeHandle handle() const { return handle_; }
+
+    int anime_id() const;
+    std::string_view name() const;
+    uint64_t genreMask() const;
+    size_t genre_count() const;
+    const std::string& genre(size_t k) const;
+    std::string_view type() const;
+    int episodes() const;
+    float rating() const;
+    int members() const;
+
+    /**
+     *  Copies the anime out of the catalog.
+     */
+    Anime anime() const;
+
+    /**
+     *  Prints the anime in the same format as `Anime::display`.
+     */
+    void display() const
+    {
+        anime().display();
+    }
+
+private:
+
+    const AnimeCatalog* catalog_;   /**< The catalog that stores the anime. */
+    AnimeHandle handle_;            /**< Position of the anime in the catalog. */
+};
+
+/**
+ *  Struct-of-arrays store for the anime catalog.
+ *
+ *  Each field lives in its own contiguous column indexed by `AnimeHandle`,
+ *  so scans that only need a few fields (ratings, members, genre masks...)
+ *  touch only those columns. Genres are kept as `GenreDictionary` ids, in
+ *  file order for display, plus the genre mask; types are interned into a
+ *  small per-catalog dictionary.
+ *
+ *  Titles and type labels are stored once in the catalog's own `StringArena`
+ *  and referenced as views, so the catalog is movable but not copyable.
+ */
+class AnimeCatalog {
+public:
+
+    static constexpr size_t MAX_TYPES = 256;        /**< Type ids are stored in one byte. */
+
+    /**
+     *  Default constructor. The catalog is empty.
+     */
+    AnimeCatalog() = default;
+
+    AnimeCatalog(const AnimeCatalog&) = delete;
+    AnimeCatalog& operator=(const AnimeCatalog&) = delete;
+    AnimeCatalog(AnimeCatalog&&) = default;
+    AnimeCatalog& operator=(AnimeCatalog&&) = default;
+
+    /**
+     *  Clears the catalog.
+     */
+    void clear()
+    {
+        ids_.clear();
+        names_.clear();
+        genreOffsets_.assign(1, 0);
+        genreIds_.clear();
+        genreMasks_.clear();
+        typeIds_.clear();
+        episodes_.clear();
+        ratings_.clear();
+        members_.clear();
+        types_.clear();
+        typeMapping_.clear();
+        strings_ = StringArena();
+    }
+
+    /**
+     *  Reserves space for the specified number of animes.
+     */
+    void reserve(size_t count)
+    {
+        ids_.reserve(count);
+        names_.reserve(count);
+        genreOffsets_.reserve(count + 1);
+        genreMasks_.reserve(count);
+        typeIds_.reserve(count);
+        episodes_.reserve(count);
+        ratings_.reserve(count);
+        members_.reserve(count);
+    }
+
+    /**
+     *  Returns the number of animes in the catalog.
+     */
+    size_t size() const
+    {
+        return ids_.size();
+    }
+
+    /**
+     *  Checks if the catalog is empty.
+     */
+    bool empty() const
+    {
+        return ids_.empty();
+    }
+
+    /**
+     *  Appends an anime from its fields.
+     *
+     *  @param[in]  id          The anime id.
+     *  @param[in]  name        The title.
+     *  @param[in]  genres      The `GenreDictionary` ids of the genres, in display order.
+     *  @param[in]  type        The type label.
+     *  @param[in]  episodes    The number of episodes.
+     *  @param[in]  rating      The rating.
+     *  @param[in]  members     The number of members.
+     *
+     *  @return The handle of the new anime.
+     *
+     *  @throw std::runtime_error if `type` would be the 257th type; the
+     *         catalog is left unchanged.
+     */
+    AnimeHandle add(int id, std::string_view name, const std::vector<unsigned>& genres, std::string_view type,
+                    int episodes, float rating, int members)
+    {
+        AnimeHandle handle = static_cast<AnimeHandle>(ids_.size());
+        uint8_t typeId = intern_type(type);
+
+        uint64_t mask = 0;
+        for (unsigned genre : genres) {
+            genreIds_.push_back(static_cast<uint8_t>(genre));
+            mask |= uint64_t(1) << genre;
+        }
+
+        ids_.push_back(id);
+        names_.push_back(strings_.store(name));
+        genreOffsets_.push_back(static_cast<uint32_t>(genreIds_.size()));
+        genreMasks_.push_back(mask);
+        typeIds_.push_back(typeId);
+        episodes_.push_back(episodes);
+        ratings_.push_back(rating);
+        members_.push_back(members);
+        return handle;
+    }
+
+    /**
+     *  Replaces the fields of an anime that is already in the catalog. The
+     *  handle does not change; the old title stays in the arena, so views
+     *  of it remain valid.
+     *
+     *  @param[in]  handle      The anime to update.
+     *
+     *  The remaining parameters are the same as in `add`.
+     *
+     *  @throw std::runtime_error if `type` would be the 257th type; the
+     *         anime is left unchanged.
+     */
+    void update(AnimeHandle handle, int id, std::string_view name, const std::vector<unsigned>& genres,
+                std::string_view type, int episodes, float rating, int members)
+    {
+        uint8_t typeId = intern_type(type);
+
+        // Splice the new genre list in place and shift the following offsets
+        uint32_t begin = genreOffsets_[handle];
+        uint32_t end = genreOffsets_[handle + 1];
+        genreIds_.erase(genreIds_.begin() + begin, genreIds_.begin() + end);
+        genreIds_.insert(genreIds_.begin() + begin, genres.size(), 0);
+
+        uint64_t mask = 0;
+        for (size_t k = 0; k < genres.size(); ++k) {
+            genreIds_[begin + k] = static_cast<uint8_t>(genres[k]);
+            mask |= uint64_t(1) << genres[k];
+        }
+        int64_t shift = static_cast<int64_t>(genres.size()) - (end - begin);
+        if (shift != 0) {
+            for (size_t h = handle + 1; h < genreOffsets_.size(); ++h)
+                genreOffsets_[h] = static_cast<uint32_t>(genreOffsets_[h] + shift);
+        }
+
+        ids_[handle] = id;
+        if (name != names_[handle])
+            names_[handle] = strings_.store(name);
+        genreMasks_[handle] = mask;
+        typeIds_[handle] = typeId;
+        episodes_[handle] = episodes;
+        ratings_[handle] = rating;
+        members_[handle] = members;
+    }
+
+    /**
+     *  Appends a copy of an anime.
+     *
+     *  @return The handle of the new anime.
+     */
+    AnimeHandle add(const Anime& anime)
+    {
+        std::vector<unsigned> genres;
+        genres.reserve(anime.genres.size());
+        for (const auto& genre : anime.genres)
+            genres.push_back(GenreDictionary::instance().intern(genre));
+
+        return add(anime.anime_id, anime.name, genres, anime.type, anime.episodes, anime.rating, anime.members);
+    }
+
+    /**
+     *  Returns a view of the anime with the specified handle.
+     */
+    AnimeRef operator[](AnimeHandle handle) const
+    {
+        return AnimeRef(*this, handle);
+    }
+
+    const std::vector<int>& ids() const { return ids_; }
+    const std::vector<std::string_view>& names() const { return names_; }
+    const std::vector<uint64_t>& genre_masks() const { return genreMasks_; }
+    const std::vector<uint8_t>& type_ids() const { return typeIds_; }
+    const std::vector<int>& episodes() const { return episodes_; }
+    const std::vector<float>& ratings() const { return ratings_; }
+    const std::vector<int>& members() const { return members_; }
+    const std::vector<uint32_t>& genre_offsets() const { return genreOffsets_; }
+    const std::vector<uint8_t>& genre_list() const { return genreIds_; }
+
+    /**
+     *  Returns the number of genres of an anime.
+     */
+    size_t genre_count(AnimeHandle handle) const
+    {
+        return genreOffsets_[handle + 1] - genreOffsets_[handle];
+    }
+
+    /**
+     *  Returns the `GenreDictionary` id of the k-th genre of an anime.
+     */
+    unsigned genre_id(AnimeHandle handle, size_t k) const
+    {
+        return genreIds_[genreOffsets_[handle] + k];
+    }
+
+    /**
+     *  Returns the type labels, indexed by type id.
+     */
+    const std::vector<std::string_view>& types() const
+    {
+        return types_;
+    }
+
+    /**
+     *  Returns the id of a type label, adding it to the dictionary if needed.
+     *
+     *  @throw std::runtime_error if the dictionary already holds `MAX_TYPES`
+     *         types.
+     */
+    uint8_t intern_type(std::string_view type)
+    {
+        auto it = typeMapping_.find(type);
+        if (it != typeMapping_.end())
+            return it->second;
+        if (types_.size() >= MAX_TYPES)
+            throw std::runtime_error("Too many types for a one-byte type id");
+
+        uint8_t id = static_cast<uint8_t>(types_.size());
+        types_.push_back(strings_.store(type));
+        typeMapping_.emplace(types_.back(), id);
+        return id;
+    }
+
+private:
+
+    std::vector<int> ids_;                              /**< anime_id column. */
+    std::vector<std::string_view> names_;               /**< Title column (views into `strings_`). */
+    std::vector<uint32_t> genreOffsets_{0};             /**< Start of each anime in `genreIds_` (size + 1 entries). */
+    std::vector<uint8_t> genreIds_;                     /**< Genre ids of all animes, back to back. */
+    std::vector<uint64_t> genreMasks_;                  /**< Genre mask column. */
+    std::vector<uint8_t> typeIds_;                      /**< Type id column. */
+    std::vector<int> episodes_;                         /**< Episodes column. */
+    std::vector<float> ratings_;                        /**< Rating column. */
+    std::vector<int> members_;                          /**< Members column. */
+
+    std::vector<std::string_view> types_;               /**< Type labels, indexed by type id. */
+    std::unordered_map<std::string_view, uint8_t> typeMapping_;  /**< Type label to type id. */
+
+    StringArena strings_;                               /**< Storage of titles and type labels. */
+};
+
+inline int AnimeRef::anime_id() const { return catalog_->ids()[handle_]; }
+inline std::string_view AnimeRef::name() const { return catalog_->names()[handle_]; }
+inline uint64_t AnimeRef::genreMask() const { return catalog_->genre_masks()[handle_]; }
+inline size_t AnimeRef::genre_count() const { return catalog_->genre_count(handle_); }
+inline std::string_view AnimeRef::type() const { return catalog_->types()[catalog_->type_ids()[handle_]]; }
+inline int AnimeRef::episodes() const { return catalog_->episodes()[handle_]; }
+inline float AnimeRef::rating() const { return catalog_->ratings()[handle_]; }
+inline int AnimeRef::members() const { return catalog_->members()[handle_]; }
+
+inline const std::string& AnimeRef::genre(size_t k) const
+{
+    return GenreDictionary::instance().name(catalog_->genre_id(handle_, k));
+}
+
+inline Anime AnimeRef::anime() const
+{
+    std::vector<std::string> genres;
+    genres.reserve(genre_count());
+    for (size_t k = 0; k < genre_count(); ++k)
+        genres.push_back(genre(k));
+
+    return Anime(anime_id(), name(), genres, type(), episodes(), rating(), members());
+}
+
+#endif // ANIME_CATALOG_HPP
@@ -0,0 +1,269 @@
+#ifndef CANDIDATE_INDEX_HPP
+#define CANDIDATE_INDEX_HPP
+
+#include "../anime.hpp"
+#include "similarityKernel.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+/**
+ *  Inverted genre index that lists, for one anime, the animes that can
+ *  reach a similarity threshold with it.
+ *
+ *  Every term of `calculateSimilarity` is at most 1, so a pair scores at
+ *  most `genre * G + type * sameType + episodes + rating + members` (the
+ *  `SimilarityWeights`), where `G = shared / max(genres(a), genres(b))`.
+ *  For the pair to reach the threshold, G must be at least `crossShare()`
+ *  for different types and `sameShare()` for the same type.
+ *
+ *  A required share `g > 0` means at least `ceil(g * n)` shared genres for
+ *  an anime with `n` genres. With the genres of every anime ordered from
+ *  rarest to most common, two animes that share that many genres share one
+ *  among the first `n - ceil(g * n) + 1` of each (prefix filtering), so
+ *  each anime is posted only under those genres: pairs of different types
+ *  in one set of posting lists, pairs of the same type in another. When the
+ *  same-type share is not positive every same-type anime is a candidate and
+ *  the type lists are used instead.
+ *
+ *  The candidates are then checked against the bound with their exact
+ *  genre overlap. The result is a superset of the pairs at or above the
+ *  threshold, so a graph built from it is exact. When the bound cannot rule
+ *  out pairs of different types (low threshold, negative weights, negative
+ *  episodes or members), `prunes()` is false and callers scan every pair.
+ */
+class CandidateIndex {
+public:
+
+    /**
+     *  Working memory of `row()`. One per thread.
+     */
+    class Scratch {
+        friend class CandidateIndex;
+        std::vector<uint32_t> seen_;        /**< Stamp of the last `row()` that reached each anime. */
+        uint32_t stamp_{0};
+    };
+
+    /**
+     *  Builds the posting lists.
+     *
+     *  @param[in]  animes      The animes, indexed as in the graph.
+     *  @param[in]  weights     The weights of `calculateSimilarity`.
+     *  @param[in]  threshold   The similarity the listed pairs may reach.
+     */
+    CandidateIndex(const std::vector<Anime>& animes, const SimilarityWeights& weights, double threshold)
+        : size_(animes.size()), genreWeight_(weights.genre), typeWeight_(weights.type),
+          otherWeights_(weights.episodes + weights.rating + weights.members), threshold_(threshold - SLACK)
+    {
+        bool bounded = weights.genre > 0 && weights.type >= 0 && weights.episodes >= 0
+                    && weights.rating >= 0 && weights.members >= 0;
+        for (const Anime& anime : animes)
+            bounded = bounded && anime.episodes >= 0 && anime.members >= 0;
+        if (!bounded)
+            return;
+
+        crossShare_ = (threshold_ - otherWeights_) / genreWeight_;
+        sameShare_ = (threshold_ - typeWeight_ - otherWeights_) / genreWeight_;
+        prunes_ = crossShare_ > 0;
+        if (!prunes_)
+            return;
+
+        // Rarest genres first
+        std::vector<uint32_t> frequency(64, 0);
+        for (const Anime& anime : animes)
+            for (uint64_t mask = anime.genreMask; mask != 0; mask &= mask - 1)
+                ++frequency[__builtin_ctzll(mask)];
+        std::vector<uint8_t> order(64);
+        for (unsigned g = 0; g < 64; ++g)
+            order[g] = static_cast<uint8_t>(g);
+        std::stable_sort(order.begin(), order.end(), [&](uint8_t a, uint8_t b) { return frequency[a] < frequency[b]; });
+
+        std::unordered_map<std::string_view, uint32_t> types;
+        genreMasks_.reserve(animes.size());
+        typeIds_.reserve(animes.size());
+        genres_.reserve(animes.size() * 3);
+        genreOffsets_.reserve(animes.size() + 1);
+        for (size_t i = 0; i < animes.size(); ++i) {
+            const Anime& anime = animes[i];
+            uint32_t type = types.emplace(anime.type, static_cast<uint32_t>(types.size())).first->second;
+            typeIds_.push_back(type);
+            genreMasks_.push_back(anime.genreMask);
+            for (uint8_t genre : order)
+                if (anime.genreMask >> genre & 1)
+                    genres_.push_back(genre);
+            genreOffsets_.push_back(static_cast<uint32_t>(genres_.size()));
+        }
+        types_ = static_cast<uint32_t>(types.size());
+
+        cross_.resize(64);
+        if (sameShare_ > 0)
+            same_.resize(size_t(types_) * 64);
+        else
+            byType_.resize(types_);
+
+        for (size_t i = 0; i < animes.size(); ++i) {
+            uint32_t v = static_cast<uint32_t>(i);
+            const uint8_t* genres = genres_.data() + genreOffsets_[i];
+            for (size_t k = 0; k < prefix(i, crossShare_); ++k)
+                cross_[genres[k]].push_back(v);
+            if (sameShare_ > 0) {
+                for (size_t k = 0; k < prefix(i, sameShare_); ++k)
+                    same_[typeIds_[i] * 64 + genres[k]].push_back(v);
+            } else {
+                byType_[typeIds_[i]].push_back(v);
+            }
+        }
+    }
+
+    /**
+     *  Checks if the bound rules out any pair. If not, `row()` must not be
+     *  used.
+     */
+    bool prunes() const
+    {
+        return prunes_;
+    }
+
+    /**
+     *  Returns the genre share a pair of different types needs to reach the
+     *  threshold (above 1: none can).
+     */
+    double crossShare() const
+    {
+        return crossShare_;
+    }
+
+    /**
+     *  Returns the genre share a pair of the same type needs to reach the
+     *  threshold (not positive: no genre needs to be shared).
+     */
+    double sameShare() const
+    {
+        return sameShare_;
+    }
+
+    /**
+     *  Returns the number of posting entries `row(i, begin, ...)` would
+     *  visit, to choose between it and scoring every pair.
+     */
+    size_t cost(size_t i, size_t begin) const
+    {
+        auto tail = [begin](const std::vector<uint32_t>& postings) {
+            return static_cast<size_t>(postings.end() - std::lower_bound(postings.begin(), postings.end(), begin));
+        };
+        const uint8_t* genres = genres_.data() + genreOffsets_[i];
+        size_t visits = 0;
+        for (size_t k = 0; k < prefix(i, crossShare_); ++k)
+            visits += tail(cross_[genres[k]]);
+        if (sameShare_ > 0) {
+            for (size_t k = 0; k < prefix(i, sameShare_); ++k)
+                visits += tail(same_[typeIds_[i] * 64 + genres[k]]);
+        } else {
+            visits += tail(byType_[typeIds_[i]]);
+        }
+        return visits;
+    }
+
+    /**
+     *  Lists the animes `j >= begin`, `j != i`, that may reach the threshold
+     *  with anime `i`.
+     *
+     *  @param[out] out     Room for `size() - begin` indices. Written in
+     *                      increasing order.
+     *
+     *  @return The number of candidates.
+     */
+    size_t row(size_t i, size_t begin, Scratch& scratch, uint32_t* out) const
+    {
+        scratch.seen_.resize(size_, 0);
+        if (++scratch.stamp_ == 0) {
+            std::fill(scratch.seen_.begin(), scratch.seen_.end(), 0);
+            scratch.stamp_ = 1;
+        }
+        const uint32_t stamp = scratch.stamp_;
+        scratch.seen_[i] = stamp;
+        const uint8_t* genres = genres_.data() + genreOffsets_[i];
+        const uint32_t type = typeIds_[i];
+        size_t count = 0;
+
+        auto probe = [&](const std::vector<uint32_t>& postings, bool sameType) {
+            for (auto it = std::lower_bound(postings.begin(), postings.end(), begin); it != postings.end(); ++it) {
+                uint32_t j = *it;
+                if (scratch.seen_[j] == stamp || (typeIds_[j] == type) != sameType)
+                    continue;
+                scratch.seen_[j] = stamp;
+                if (bound(i, j, sameType) >= threshold_)
+                    out[count++] = j;
+            }
+        };
+
+        for (size_t k = 0; k < prefix(i, crossShare_); ++k)
+            probe(cross_[genres[k]], false);
+
+        if (sameShare_ > 0) {
+            for (size_t k = 0; k < prefix(i, sameShare_); ++k)
+                probe(same_[type * 64 + genres[k]], true);
+        } else {
+            const std::vector<uint32_t>& sameType = byType_[type];
+            for (auto it = std::lower_bound(sameType.begin(), sameType.end(), begin); it != sameType.end(); ++it)
+                if (*it != i)
+                    out[count++] = *it;
+        }
+
+        std::sort(out, out + count);
+        return count;
+    }
+
+    /**
+     *  Returns the number of animes.
+     */
+    size_t size() const
+    {
+        return size_;
+    }
+
+private:
+
+    static constexpr double SLACK = 1e-9;       /**< Keeps pairs right at the threshold despite rounding. */
+
+    size_t size_;
+    double genreWeight_;
+    double typeWeight_;
+    double otherWeights_;                       /**< Largest episode, rating and member terms together. */
+    double threshold_;
+    double crossShare_{0};
+    double sameShare_{0};
+    bool prunes_{false};
+    uint32_t types_{0};
+
+    std::vector<uint64_t> genreMasks_;          /**< Genre mask column. */
+    std::vector<uint32_t> typeIds_;             /**< Type column, as ids local to the index. */
+    std::vector<uint8_t> genres_;               /**< Genres of every anime, rarest first, back to back. */
+    std::vector<uint32_t> genreOffsets_{0};     /**< Start of each anime in `genres_` (size + 1 entries). */
+    std::vector<std::vector<uint32_t>> cross_;  /**< Animes with each genre in their cross-type prefix. */
+    std::vector<std::vector<uint32_t>> same_;   /**< Per type and genre, animes with it in their same-type prefix. */
+    std::vector<std::vector<uint32_t>> byType_; /**< Animes of each type, when same-type pairs need no genre. */
+
+    // Genres of anime `i` that must be indexed and probed for a required share
+    size_t prefix(size_t i, double share) const
+    {
+        size_t genres = genreOffsets_[i + 1] - genreOffsets_[i];
+        if (share > 1 || genres == 0)
+            return 0;
+        double needed = std::ceil(share * genres - SLACK);
+        return genres - static_cast<size_t>(std::max(needed, 1.0)) + 1;
+    }
+
+    double bound(size_t i, size_t j, bool sameType) const
+    {
+        unsigned shared = genreCount(genreMasks_[i] & genreMasks_[j]);
+        unsigned most = std::max(genreCount(genreMasks_[i]), genreCount(genreMasks_[j]));
+        return genreWeight_ * shared / most + (sameType ? typeWeight_ : 0.0) + otherWeights_;
+    }
+};
+
+#endif // CANDIDATE_INDEX_HPP
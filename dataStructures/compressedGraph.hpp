@@ -0,0 +1,332 @@
+#ifndef COMPRESSED_GRAPH_HPP
+#define COMPRESSED_GRAPH_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+/**
+ *  Read-only undirected weighted graph with compressed adjacency lists.
+ *
+ *  Row `v` lists the neighbors of vertex `v` in increasing order: the first
+ *  one as a varint (LEB128, 7 bits per byte) and every other one as a varint
+ *  of its gap to the previous neighbor. Ids of similar vertices are close,
+ *  so most gaps take one byte.
+ *
+ *  Weights are stored apart from the ids, one code of `weight_bits()` bits
+ *  (8 or 16) per entry, so traversals that ignore weights never read them.
+ *  A weight `w` in [0, max_weight()] is stored as `round(w / step)`, with
+ *  `step = max_weight() / (2^bits - 1)`, and read back as `code * step`.
+ *  The error is at most `step / 2` plus float rounding (`weight_error()`).
+ *  For similarity graphs `max_weight()` is `1 - threshold`.
+ *
+ *  Rows are appended in vertex order with `append_row`; a graph is built
+ *  with `from` or streamed row by row (see `buildCompressedGraph`).
+ */
+class CompressedGraph {
+public:
+
+    /**
+     *  Creates a graph without vertices.
+     *
+     *  @param[in]  maxWeight   The largest weight that will be stored.
+     *  @param[in]  weightBits  Bits per weight code, 8 or 16.
+     */
+    explicit CompressedGraph(float maxWeight = 1.0f, unsigned weightBits = 8)
+        : maxWeight_(maxWeight), weightBits_(weightBits)
+    {
+        if (weightBits != 8 && weightBits != 16)
+            throw std::invalid_argument("Weights are quantized to 8 or 16 bits");
+        if (!(maxWeight > 0))
+            throw std::invalid_argument("The largest weight must be positive");
+        step_ = maxWeight / static_cast<float>((1u << weightBits) - 1);
+    }
+
+    /**
+     *  Compresses the neighbor rows of a graph; tombstones get empty rows.
+     *
+     *  @param[in]  graph       Any graph with `vertices()`, `is_alive()`,
+     *                          `neighbors()`, `neighbor_weights()` and a
+     *                          static `decode()` for the stored weights.
+     *  @param[in]  maxWeight   The largest weight of the graph.
+     *  @param[in]  weightBits  Bits per weight code, 8 or 16.
+     */
+    template <typename Graph>
+    static CompressedGraph from(const Graph& graph, float maxWeight, unsigned weightBits = 8)
+    {
+        CompressedGraph compressed(maxWeight, weightBits);
+        std::vector<std::pair<uint32_t, float>> row;
+        for (size_t v = 0; v < graph.vertices().size(); ++v) {
+            row.clear();
+            if (graph.is_alive(v)) {
+                auto neighbors = graph.neighbors(v);
+                auto weights = graph.neighbor_weights(v);
+                for (size_t k = 0; k < neighbors.size(); ++k)
+                    row.emplace_back(neighbors[k], static_cast<float>(Graph::decode(weights[k])));
+            }
+            compressed.append_row(row);
+        }
+        return compressed;
+    }
+
+    /**
+     *  Appends the row of the next vertex.
+     *
+     *  @param[in,out]  row     Pairs of neighbor and weight, without repeated
+     *                          neighbors. Sorted by neighbor in place.
+     */
+    void append_row(std::vector<std::pair<uint32_t, float>>& row)
+    {
+        if (!std::is_sorted(row.begin(), row.end()))
+            std::sort(row.begin(), row.end());
+
+        if (rowBytes_.empty()) {
+            rowBytes_.push_back(0);
+            rowEntries_.push_back(0);
+        }
+
+        uint32_t previous = 0;
+        for (size_t k = 0; k < row.size(); ++k) {
+            encode(k == 0 ? row[k].first : row[k].first - previous);
+            previous = row[k].first;
+
+            uint32_t code = quantize(row[k].second);
+            codes_.push_back(static_cast<uint8_t>(code));
+            if (weightBits_ == 16)
+                codes_.push_back(static_cast<uint8_t>(code >> 8));
+        }
+
+        rowBytes_.push_back(bytes_.size());
+        rowEntries_.push_back(rowEntries_.back() + row.size());
+    }
+
+    /**
+     *  Releases the spare capacity left by the appends.
+     */
+    void shrink_to_fit()
+    {
+        bytes_.shrink_to_fit();
+        codes_.shrink_to_fit();
+        rowBytes_.shrink_to_fit();
+        rowEntries_.shrink_to_fit();
+    }
+
+    /**
+     *  Returns the number of vertices.
+     */
+    size_t vertex_count() const
+    {
+        return rowBytes_.empty() ? 0 : rowBytes_.size() - 1;
+    }
+
+    /**
+     *  Returns the number of edges (each edge is in two rows).
+     */
+    size_t edge_count() const
+    {
+        return rowEntries_.empty() ? 0 : rowEntries_.back() / 2;
+    }
+
+    /**
+     *  Returns the number of neighbors of a vertex.
+     */
+    size_t degree(size_t vertex) const
+    {
+        return rowEntries_[vertex + 1] - rowEntries_[vertex];
+    }
+
+    /**
+     *  Returns the largest weight that can be stored.
+     */
+    float max_weight() const
+    {
+        return maxWeight_;
+    }
+
+    /**
+     *  Returns the bits per weight code.
+     */
+    unsigned weight_bits() const
+    {
+        return weightBits_;
+    }
+
+    /**
+     *  Returns the largest difference between a stored weight and the
+     *  weight it was built from.
+     */
+    float weight_error() const
+    {
+        return step_ / 2 + maxWeight_ * 1e-6f;
+    }
+
+    /**
+     *  Returns the memory used by the graph, in bytes.
+     */
+    size_t bytes() const
+    {
+        return bytes_.capacity() + codes_.capacity()
+             + (rowBytes_.capacity() + rowEntries_.capacity()) * sizeof(uint64_t);
+    }
+
+    /**
+     *  Returns `bytes()` per edge, or 0 for a graph without edges.
+     */
+    double bytes_per_edge() const
+    {
+        return edge_count() == 0 ? 0.0 : static_cast<double>(bytes()) / edge_count();
+    }
+
+    /**
+     *  Calls `visit(neighbor)` for every neighbor of a vertex, in increasing
+     *  order. Weights are not decoded.
+     */
+    template <typename Visit>
+    void for_each_neighbor(size_t vertex, Visit visit) const
+    {
+        const uint8_t* in = bytes_.data() + rowBytes_[vertex];
+        const uint8_t* end = bytes_.data() + rowBytes_[vertex + 1];
+        uint32_t neighbor = 0;
+
+        // Dense rows are mostly one-byte gaps: take 8 of them per load
+        while (end - in >= 8) {
+            uint64_t word;
+            std::memcpy(&word, in, sizeof(word));
+            if (word & 0x8080808080808080ULL) {
+                neighbor += decode(in);
+                visit(neighbor);
+                continue;
+            }
+            for (unsigned k = 0; k < 8; ++k) {
+                neighbor += static_cast<uint32_t>(word >> (8 * k)) & 0x7f;
+                visit(neighbor);
+            }
+            in += 8;
+        }
+        while (in != end) {
+            neighbor += decode(in);
+            visit(neighbor);
+        }
+    }
+
+    /**
+     *  Calls `visit(neighbor, weight)` for every neighbor of a vertex, in
+     *  increasing order.
+     */
+    template <typename Visit>
+    void for_each_edge(size_t vertex, Visit visit) const
+    {
+        const uint8_t* in = bytes_.data() + rowBytes_[vertex];
+        const uint8_t* end = bytes_.data() + rowBytes_[vertex + 1];
+        size_t entry = rowEntries_[vertex];
+        uint32_t neighbor = 0;
+        while (in != end) {
+            neighbor += decode(in);
+            visit(neighbor, weight_at(entry++));
+        }
+    }
+
+    /**
+     *  Returns the neighbors of a vertex, in increasing order.
+     */
+    std::vector<uint32_t> neighbors(size_t vertex) const
+    {
+        std::vector<uint32_t> result;
+        result.reserve(degree(vertex));
+        for_each_neighbor(vertex, [&result](uint32_t neighbor) { result.push_back(neighbor); });
+        return result;
+    }
+
+    /**
+     *  Returns the weight of the edge between two vertices, or -1 if there
+     *  is no such edge. O(degree).
+     */
+    float weight(size_t v1, size_t v2) const
+    {
+        float found = -1;
+        for_each_edge(v1, [&found, v2](uint32_t neighbor, float weight) {
+            if (neighbor == v2)
+                found = weight;
+        });
+        return found;
+    }
+
+    /**
+     *  Breadth-first traversal.
+     *
+     *  @param[in]  start   The first vertex.
+     *
+     *  @return The vertices reached from `start`, in visiting order.
+     */
+    std::vector<uint32_t> bfs(size_t start) const
+    {
+        std::vector<uint32_t> order;
+        std::vector<bool> explored(vertex_count(), false);
+        order.push_back(static_cast<uint32_t>(start));
+        explored[start] = true;
+
+        // `order` doubles as the queue
+        for (size_t head = 0; head < order.size(); ++head) {
+            for_each_neighbor(order[head], [&](uint32_t neighbor) {
+                if (!explored[neighbor]) {
+                    explored[neighbor] = true;
+                    order.push_back(neighbor);
+                }
+            });
+        }
+        return order;
+    }
+
+private:
+
+    std::vector<uint8_t> bytes_;            /**< Varint neighbor gaps of every row. */
+    std::vector<uint8_t> codes_;            /**< Weight codes, little endian when 16 bits. */
+    std::vector<uint64_t> rowBytes_;        /**< Start of each row in `bytes_`, plus the end. */
+    std::vector<uint64_t> rowEntries_;      /**< Entries before each row, plus the total. */
+    float maxWeight_;
+    unsigned weightBits_;
+    float step_;                            /**< Weight of one code unit. */
+
+    void encode(uint32_t value)
+    {
+        while (value >= 0x80) {
+            bytes_.push_back(static_cast<uint8_t>(value | 0x80));
+            value >>= 7;
+        }
+        bytes_.push_back(static_cast<uint8_t>(value));
+    }
+
+    static uint32_t decode(const uint8_t*& in)
+    {
+        uint32_t value = *in++;
+        if (value < 0x80)
+            return value;
+        value &= 0x7f;
+        for (unsigned shift = 7;; shift += 7) {
+            uint32_t byte = *in++;
+            value |= (byte & 0x7f) << shift;
+            if (byte < 0x80)
+                return value;
+        }
+    }
+
+    uint32_t quantize(float weight) const
+    {
+        float code = std::nearbyint(std::clamp(weight, 0.0f, maxWeight_) / step_);
+        return std::min(static_cast<uint32_t>(code), (1u << weightBits_) - 1);
+    }
+
+    float weight_at(size_t entry) const
+    {
+        uint32_t code = weightBits_ == 8 ? codes_[entry]
+                                         : codes_[2 * entry] | (uint32_t(codes_[2 * entry + 1]) << 8);
+        return static_cast<float>(code) * step_;
+    }
+};
+
+#endif
@@ -0,0 +1,178 @@
+#ifndef EDGE_INDEX_HPP
+#define EDGE_INDEX_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+/**
+ *  Hash table from an unordered pair of vertex indices to the position of
+ *  the edge in the edge list of a graph.
+ *
+ *  Open addressing with linear probing; deletions shift the following
+ *  entries back, so there are no tombstones and lookups stay short. The
+ *  table doubles when it is half full.
+ */
+class EdgeIndex {
+public:
+
+    static constexpr uint32_t NONE = UINT32_MAX;    /**< Returned by `find` when the edge is not indexed. */
+
+    /**
+     *  Builds the key of the edge between two vertices. The key does not
+     *  depend on the order of the vertices.
+     *
+     *  @param[in]  a   Index of one vertex.
+     *  @param[in]  b   Index of the other vertex.
+     *
+     *  @return The key of the edge.
+     */
+    static uint64_t key(uint32_t a, uint32_t b)
+    {
+        if (a > b)
+            std::swap(a, b);
+        return (static_cast<uint64_t>(a) << 32) | b;
+    }
+
+    /**
+     *  Removes every entry.
+     */
+    void clear()
+    {
+        slots_.clear();
+        size_ = 0;
+    }
+
+    /**
+     *  Makes room for `count` entries without growing.
+     */
+    void reserve(size_t count)
+    {
+        size_t capacity = 16;
+        while (capacity < count * 2)
+            capacity *= 2;
+        if (capacity > slots_.size())
+            rehash(capacity);
+    }
+
+    /**
+     *  Returns the number of entries.
+     */
+    size_t size() const
+    {
+        return size_;
+    }
+
+    /**
+     *  Looks up an edge.
+     *
+     *  @param[in]  k   The key of the edge.
+     *
+     *  @return The position of the edge, or `NONE` if it is not indexed.
+     */
+    uint32_t find(uint64_t k) const
+    {
+        if (slots_.empty())
+            return NONE;
+        for (size_t i = slot_of(k);; i = (i + 1) & mask()) {
+            if (slots_[i].key == k)
+                return slots_[i].position;
+            if (slots_[i].key == EMPTY)
+                return NONE;
+        }
+    }
+
+    /**
+     *  Adds an edge, or changes its position if it is already indexed.
+     *
+     *  @param[in]  k           The key of the edge.
+     *  @param[in]  position    The position of the edge in the edge list.
+     */
+    void insert(uint64_t k, uint32_t position)
+    {
+        if ((size_ + 1) * 2 > slots_.size())
+            rehash(slots_.empty() ? 16 : slots_.size() * 2);
+
+        size_t i = slot_of(k);
+        while (slots_[i].key != EMPTY && slots_[i].key != k)
+            i = (i + 1) & mask();
+        if (slots_[i].key == EMPTY)
+            ++size_;
+        slots_[i] = { k, position };
+    }
+
+    /**
+     *  Removes an edge. Does nothing if it is not indexed.
+     *
+     *  @param[in]  k   The key of the edge.
+     */
+    void erase(uint64_t k)
+    {
+        if (slots_.empty())
+            return;
+
+        size_t i = slot_of(k);
+        while (slots_[i].key != k) {
+            if (slots_[i].key == EMPTY)
+                return;
+            i = (i + 1) & mask();
+        }
+
+        // Shift back the entries of the same probe run that would become
+        // unreachable through the hole.
+        for (size_t j = (i + 1) & mask(); slots_[j].key != EMPTY; j = (j + 1) & mask()) {
+            size_t home = slot_of(slots_[j].key);
+            if (((j - home) & mask()) >= ((j - i) & mask())) {
+                slots_[i] = slots_[j];
+                i = j;
+            }
+        }
+        slots_[i].key = EMPTY;
+        --size_;
+    }
+
+private:
+
+    static constexpr uint64_t EMPTY = UINT64_MAX;   /**< Key of a free slot; no edge has it, since loops are not allowed. */
+
+    struct Slot {
+        uint64_t key = EMPTY;
+        uint32_t position = NONE;
+    };
+
+    std::vector<Slot> slots_;   /**< The table; its size is a power of two. */
+    size_t size_ = 0;           /**< Number of used slots. */
+
+    size_t mask() const
+    {
+        return slots_.size() - 1;
+    }
+
+    size_t slot_of(uint64_t k) const
+    {
+        // splitmix64 finalizer
+        k ^= k >> 30;
+        k *= 0xbf58476d1ce4e5b9ULL;
+        k ^= k >> 27;
+        k *= 0x94d049bb133111ebULL;
+        k ^= k >> 31;
+        return static_cast<size_t>(k) & mask();
+    }
+
+    void rehash(size_t capacity)
+    {
+        std::vector<Slot> old(capacity);
+        old.swap(slots_);
+        for (const Slot& slot : old) {
+            if (slot.key == EMPTY)
+                continue;
+            size_t i = slot_of(slot.key);
+            while (slots_[i].key != EMPTY)
+                i = (i + 1) & mask();
+            slots_[i] = slot;
+        }
+    }
+};
+
+#endif
@@ -0,0 +1,108 @@
+#ifndef GENRE_DICTIONARY_HPP
+#define GENRE_DICTIONARY_HPP
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+/**
+ *  Process-wide dictionary that interns genre names into small ids, so the
+ *  genres of an anime fit in a 64-bit mask (bit `id` set for each genre).
+ *
+ *  Ids are assigned in order of first appearance and never change. Interning
+ *  is thread-safe; names are published before the count, so `name()` and
+ *  `size()` can be read without locking.
+ */
+class GenreDictionary {
+public:
+
+    static constexpr unsigned MAX_GENRES = 64;     /**< One bit per genre in a `uint64_t`. */
+
+    /**
+     *  Returns the shared dictionary.
+     */
+    static GenreDictionary& instance()
+    {
+        static GenreDictionary dictionary;
+        return dictionary;
+    }
+
+    /**
+     *  Returns the id of a genre, adding it to the dictionary if needed.
+     *
+     *  @param[in]  genre   The genre name.
+     *
+     *  @return The id of the genre.
+     *
+     *  @throw std::runtime_error if the dictionary already holds 64 genres.
+     */
+    unsigned intern(std::string_view genre)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+
+        auto it = ids_.find(genre);
+        if (it != ids_.end())
+            return it->second;
+
+        unsigned id = size_.load(std::memory_order_relaxed);
+        if (id >= MAX_GENRES)
+            throw std::runtime_error("Too many genres for a 64-bit genre mask");
+
+        names_[id] = std::string(genre);
+        ids_.emplace(names_[id], id);
+        size_.store(id + 1, std::memory_order_release);
+        return id;
+    }
+
+    /**
+     *  Looks up the id of a genre without adding it.
+     *
+     *  @return The id of the genre, or -1 if it is unknown.
+     */
+    int find(std::string_view genre) const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = ids_.find(genre);
+        return it != ids_.end() ? static_cast<int>(it->second) : -1;
+    }
+
+    /**
+     *  Returns the name of a genre id.
+     */
+    const std::string& name(unsigned id) const
+    {
+        return names_[id];
+    }
+
+    /**
+     *  Returns the number of genres interned so far.
+     */
+    unsigned size() const
+    {
+        return size_.load(std::memory_order_acquire);
+    }
+
+private:
+
+    GenreDictionary() = default;
+
+    std::array<std::string, MAX_GENRES> names_;                 /**< Genre names, indexed by id. */
+    std::unordered_map<std::string_view, unsigned> ids_;        /**< Views of `names_` to ids. */
+    std::atomic<unsigned> size_{0};                             /**< Number of ids in use. */
+    mutable std::mutex mutex_;                                  /**< Guards `ids_` and new ids. */
+};
+
+/**
+ *  Returns the number of genres in a genre mask.
+ */
+inline unsigned genreCount(uint64_t mask)
+{
+    return static_cast<unsigned>(__builtin_popcountll(mask));
+}
+
+#endif // GENRE_DICTIONARY_HPP
@@ -0,0 +1,194 @@
+#ifndef LSH_INDEX_HPP
+#define LSH_INDEX_HPP
+
+#include "../anime.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+/**
+ *  Parameters of `LshIndex`. More bands find more of the similar pairs and
+ *  score more pairs; more rows per band make the buckets smaller.
+ */
+struct LshParams {
+    unsigned bands = 16;        /**< Independent bucketings of the catalog. */
+    unsigned rows = 3;          /**< MinHash values of the genre set in the key of a band. */
+    bool byType = true;         /**< Put the type in the key (pairs of different types are never scored). */
+    double ratingWidth = 4.0;   /**< Width of a rating bucket, in rating points (0: rating not in the key). */
+    double episodeRatio = 8.0;  /**< Episode buckets span this ratio of episode counts (1 or less: not in the key). */
+    size_t window = 512;        /**< Bucket neighbours each anime is scored against in a band. */
+    uint64_t seed = 0x9e3779b97f4a7c15ULL;
+};
+
+/**
+ *  Locality-sensitive bucketing of animes for the approximate similarity
+ *  graph.
+ *
+ *  Every band puts each anime in one bucket, keyed by `rows` MinHash values
+ *  of its genre set (two genre sets with Jaccard similarity J get the same
+ *  value with probability J), its type and its rating and episode buckets.
+ *  The numeric grids are shifted by a different fraction of a bucket in
+ *  every band, so two close values that fall on both sides of a bucket edge
+ *  in one band share a bucket in others.
+ *
+ *  Inside a bucket the animes are shuffled, differently in every band, and
+ *  a band lists the pairs at most `window` places apart, so the pairs of a
+ *  bucket larger than the window are spread over the bands; `listedBefore()`
+ *  tells if an earlier band already paired two animes. Each band pairs an
+ *  anime with at most `window` others, so building the index is
+ *  O(bands * V log V) and listing the pairs O(bands * V * window), whatever
+ *  the catalog looks like. The index keeps 8 bytes per anime and band.
+ */
+class LshIndex {
+public:
+
+    /**
+     *  Sorts the animes into the buckets of every band.
+     *
+     *  @param[in]  animes  The animes, indexed as in the graph.
+     *  @param[in]  params  Bands, rows and bucket sizes.
+     */
+    LshIndex(const std::vector<Anime>& animes, const LshParams& params)
+        : params_(params), size_(animes.size())
+    {
+        params_.bands = std::max(1u, params_.bands);
+        params_.rows = std::max(1u, params_.rows);
+        std::unordered_map<std::string_view, uint32_t> types;
+        std::vector<uint32_t> typeIds;
+        typeIds.reserve(size_);
+        for (const Anime& anime : animes)
+            typeIds.push_back(types.emplace(anime.type, static_cast<uint32_t>(types.size())).first->second);
+
+        // (bucket key, hash and index): buckets end up contiguous, in a different order in every band
+        std::vector<std::pair<uint64_t, uint64_t>> order(size_);
+        slots_.resize(size_ * params_.bands);
+        for (unsigned b = 0; b < params_.bands; ++b) {
+            for (size_t i = 0; i < size_; ++i) {
+                uint64_t rank = (mix(params_.seed ^ (uint64_t(b) << 32 | i)) & 0xffffffff00000000ULL) | i;
+                order[i] = { key(b, animes[i], typeIds[i]), rank };
+            }
+            std::sort(order.begin(), order.end());
+            uint32_t bucket = 0;
+            for (size_t p = 0; p < size_; ++p) {
+                if (p > 0 && order[p].first != order[p - 1].first)
+                    bucket = static_cast<uint32_t>(p);
+                slots_[static_cast<uint32_t>(order[p].second) * size_t(params_.bands) + b] = { bucket, static_cast<uint32_t>(p) };
+            }
+        }
+    }
+
+    /**
+     *  Returns the number of bands.
+     */
+    unsigned bands() const
+    {
+        return params_.bands;
+    }
+
+    /**
+     *  Returns the number of animes.
+     */
+    size_t size() const
+    {
+        return size_;
+    }
+
+    /**
+     *  Lays out band `b`: the anime at position `p` of `animes` is paired
+     *  with the animes at positions `p + 1` to `ends[p] - 1`.
+     *
+     *  @param[out] animes  The animes in the order of the band.
+     *  @param[out] ends    The end of the window of each position.
+     */
+    void band(unsigned b, std::vector<uint32_t>& animes, std::vector<uint32_t>& ends) const
+    {
+        animes.resize(size_);
+        ends.resize(size_);
+        for (size_t i = 0; i < size_; ++i)
+            animes[slots_[i * params_.bands + b].position] = static_cast<uint32_t>(i);
+
+        // Walking backwards gives the end of each bucket
+        size_t bucketEnd = size_;
+        for (size_t p = size_; p-- > 0;) {
+            const Slot& slot = slots_[animes[p] * size_t(params_.bands) + b];
+            ends[p] = static_cast<uint32_t>(std::min(bucketEnd, p + 1 + params_.window));
+            if (slot.bucket == p)
+                bucketEnd = p;
+        }
+    }
+
+    /**
+     *  Checks if a band before `b` pairs animes `i` and `j`. Callers skip
+     *  those pairs so each one comes up once.
+     */
+    bool listedBefore(unsigned b, size_t i, size_t j) const
+    {
+        const Slot* a = &slots_[i * params_.bands];
+        const Slot* c = &slots_[j * params_.bands];
+        for (unsigned k = 0; k < b; ++k) {
+            uint32_t distance = a[k].position > c[k].position ? a[k].position - c[k].position : c[k].position - a[k].position;
+            if (a[k].bucket == c[k].bucket && distance <= params_.window)
+                return true;
+        }
+        return false;
+    }
+
+private:
+
+    struct Slot {
+        uint32_t bucket;                /**< First position of the bucket in the band. */
+        uint32_t position;              /**< Position of the anime in the band. */
+    };
+
+    LshParams params_;
+    size_t size_;
+    std::vector<Slot> slots_;           /**< Slot of every anime in every band (anime-major). */
+
+    // splitmix64: every value of `h` gives a different hash function
+    static uint64_t mix(uint64_t h)
+    {
+        h += 0x9e3779b97f4a7c15ULL;
+        h = (h ^ (h >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        h = (h ^ (h >> 27)) * 0x94d049bb133111ebULL;
+        return h ^ (h >> 31);
+    }
+
+    // Fraction of a bucket grid k is shifted by (golden ratio sequence)
+    static double shift(uint64_t k)
+    {
+        double offset = 0.6180339887498949 * (k + 1);
+        return offset - std::floor(offset);
+    }
+
+    // Bucket of `value` (in bucket widths) on grid k
+    static uint64_t bucket(double value, uint64_t k)
+    {
+        return static_cast<uint64_t>(static_cast<int64_t>(std::floor(value + shift(k))));
+    }
+
+    uint64_t key(unsigned b, const Anime& anime, uint32_t typeId) const
+    {
+        uint64_t h = mix(params_.seed ^ b);
+        for (unsigned r = 0; r < params_.rows; ++r) {
+            // MinHash: the least hash of the genres, with one function per row of each band
+            uint64_t function = mix(params_.seed + uint64_t(b) * params_.rows + r + 1);
+            uint64_t least = UINT64_MAX;
+            for (uint64_t mask = anime.genreMask; mask != 0; mask &= mask - 1)
+                least = std::min(least, mix(function ^ static_cast<uint64_t>(__builtin_ctzll(mask))));
+            h = mix(h ^ least);
+        }
+        if (params_.byType)
+            h = mix(h ^ typeId);
+        if (params_.ratingWidth > 0)
+            h = mix(h ^ bucket(anime.rating / params_.ratingWidth, 2 * uint64_t(b)));
+        if (params_.episodeRatio > 1)
+            h = mix(h ^ bucket(std::log(std::max(anime.episodes, 1)) / std::log(params_.episodeRatio), 2 * uint64_t(b) + 1));
+        return h;
+    }
+};
+
+#endif // LSH_INDEX_HPP
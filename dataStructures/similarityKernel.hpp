@@ -0,0 +1,430 @@
+#ifndef SIMILARITY_KERNEL_HPP
+#define SIMILARITY_KERNEL_HPP
+
+#include "../anime.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define SIMILARITY_KERNEL_X86 1
+#endif
+
+/**
+ *  Weight of each attribute in `calculateSimilarity`. The defaults add up
+ *  to 1, so the similarity stays in [0, 1].
+ */
+struct SimilarityWeights {
+    double genre = 0.4;         /**< Shared genres. */
+    double type = 0.2;          /**< Same type. */
+    double episodes = 0.15;     /**< Episode count. */
+    double rating = 0.15;       /**< Rating. */
+    double members = 0.1;       /**< Member count. */
+};
+
+/**
+ *  Instruction sets the similarity kernel can use, from slowest to fastest.
+ */
+enum class SimilarityLevel { Scalar, SSE2, AVX2 };
+
+/**
+ *  Returns the fastest similarity level supported by the running CPU. The
+ *  check is done once.
+ */
+inline SimilarityLevel bestSimilarityLevel()
+{
+#ifdef SIMILARITY_KERNEL_X86
+    static const SimilarityLevel level = __builtin_cpu_supports("avx2") ? SimilarityLevel::AVX2 : SimilarityLevel::SSE2;
+    return level;
+#else
+    return SimilarityLevel::Scalar;
+#endif
+}
+
+namespace similarity_detail {
+
+/**
+ *  Flat attribute columns of the candidates plus the attributes of the
+ *  anime they are scored against.
+ */
+struct Block {
+
+    const uint64_t* genreMasks;
+    const float* genreCounts;
+    const int32_t* typeIds;
+    const float* episodes;
+    const float* ratings;
+    const float* members;
+
+    uint64_t genreMask;         /**< Attributes of the anime scored against. */
+    float genreCount;
+    int32_t typeId;
+    float episode;
+    float rating;
+    float member;
+
+    float weights[5];           /**< `SimilarityWeights`, in declaration order. */
+};
+
+/**
+ *  Stores the score of candidate `j` and/or appends `j` to the selection if
+ *  the score reaches the threshold. Either output may be null.
+ */
+inline size_t emit(float score, uint32_t j, float threshold, float* scores, uint32_t* selected, size_t count)
+{
+    if (scores)
+        scores[j] = score;
+    if (selected && score >= threshold)
+        selected[count++] = j;
+    return count;
+}
+
+inline float scoreOne(const Block& b, size_t j)
+{
+    float genre = static_cast<float>(genreCount(b.genreMask & b.genreMasks[j])) / std::max(b.genreCount, b.genreCounts[j]);
+    float type = b.typeId == b.typeIds[j] ? 1.0f : 0.0f;
+    float episode = 1.0f - std::abs(b.episode - b.episodes[j]) / std::max(b.episode, b.episodes[j]);
+    float rating = 1.0f - std::abs(b.rating - b.ratings[j]) / 10.0f;
+    float member = 1.0f - std::abs(b.member - b.members[j]) / std::max(b.member, b.members[j]);
+    return b.weights[0] * genre + b.weights[1] * type + b.weights[2] * episode
+         + b.weights[3] * rating + b.weights[4] * member;
+}
+
+inline size_t scoreScalar(const Block& b, size_t begin, size_t end, float threshold, float* scores, uint32_t* selected)
+{
+    size_t count = 0;
+    for (size_t j = begin; j < end; ++j)
+        count = emit(scoreOne(b, j), static_cast<uint32_t>(j), threshold, scores, selected, count);
+    return count;
+}
+
+#ifdef SIMILARITY_KERNEL_X86
+
+inline size_t scoreSSE2(const Block& b, size_t begin, size_t end, float threshold, float* scores, uint32_t* selected)
+{
+    const __m128 sign = _mm_set1_ps(-0.0f);
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 ten = _mm_set1_ps(10.0f);
+    const __m128 limit = _mm_set1_ps(threshold);
+    const __m128 genreCount = _mm_set1_ps(b.genreCount);
+    const __m128i typeId = _mm_set1_epi32(b.typeId);
+    const __m128 episode = _mm_set1_ps(b.episode);
+    const __m128 rating = _mm_set1_ps(b.rating);
+    const __m128 member = _mm_set1_ps(b.member);
+
+    size_t count = 0;
+    size_t j = begin;
+    for (; j + 4 <= end; j += 4) {
+        // SSE2 has no byte shuffle for a vector popcount: count the four masks one by one
+        alignas(16) float common[4];
+        for (unsigned k = 0; k < 4; ++k)
+            common[k] = static_cast<float>(::genreCount(b.genreMask & b.genreMasks[j + k]));
+        __m128 genre = _mm_div_ps(_mm_load_ps(common), _mm_max_ps(genreCount, _mm_loadu_ps(b.genreCounts + j)));
+
+        __m128i types = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b.typeIds + j));
+        __m128 type = _mm_and_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(types, typeId)), one);
+
+        __m128 episodes = _mm_loadu_ps(b.episodes + j);
+        __m128 episodeSim = _mm_sub_ps(one, _mm_div_ps(_mm_andnot_ps(sign, _mm_sub_ps(episode, episodes)),
+                                                       _mm_max_ps(episode, episodes)));
+        __m128 ratings = _mm_loadu_ps(b.ratings + j);
+        __m128 ratingSim = _mm_sub_ps(one, _mm_div_ps(_mm_andnot_ps(sign, _mm_sub_ps(rating, ratings)), ten));
+        __m128 members = _mm_loadu_ps(b.members + j);
+        __m128 memberSim = _mm_sub_ps(one, _mm_div_ps(_mm_andnot_ps(sign, _mm_sub_ps(member, members)),
+                                                      _mm_max_ps(member, members)));
+
+        __m128 score = _mm_mul_ps(_mm_set1_ps(b.weights[0]), genre);
+        score = _mm_add_ps(score, _mm_mul_ps(_mm_set1_ps(b.weights[1]), type));
+        score = _mm_add_ps(score, _mm_mul_ps(_mm_set1_ps(b.weights[2]), episodeSim));
+        score = _mm_add_ps(score, _mm_mul_ps(_mm_set1_ps(b.weights[3]), ratingSim));
+        score = _mm_add_ps(score, _mm_mul_ps(_mm_set1_ps(b.weights[4]), memberSim));
+
+        if (scores)
+            _mm_storeu_ps(scores + j, score);
+        if (selected) {
+            unsigned bits = static_cast<unsigned>(_mm_movemask_ps(_mm_cmpge_ps(score, limit)));
+            while (bits != 0) {
+                selected[count++] = static_cast<uint32_t>(j + __builtin_ctz(bits));
+                bits &= bits - 1;
+            }
+        }
+    }
+    return count + scoreScalar(b, j, end, threshold, scores, selected ? selected + count : nullptr);
+}
+
+/**
+ *  Number of set bits of each 64-bit lane (nibble lookup table).
+ */
+__attribute__((target("avx2")))
+inline __m256i popcount64(__m256i v)
+{
+    const __m256i table = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+                                           0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+    const __m256i low = _mm256_set1_epi8(0x0f);
+    __m256i counts = _mm256_add_epi8(_mm256_shuffle_epi8(table, _mm256_and_si256(v, low)),
+                                     _mm256_shuffle_epi8(table, _mm256_and_si256(_mm256_srli_epi16(v, 4), low)));
+    return _mm256_sad_epu8(counts, _mm256_setzero_si256());
+}
+
+__attribute__((target("avx2")))
+inline size_t scoreAVX2(const Block& b, size_t begin, size_t end, float threshold, float* scores, uint32_t* selected)
+{
+    const __m256 sign = _mm256_set1_ps(-0.0f);
+    const __m256 one = _mm256_set1_ps(1.0f);
+    const __m256 ten = _mm256_set1_ps(10.0f);
+    const __m256 limit = _mm256_set1_ps(threshold);
+    const __m256i genreMask = _mm256_set1_epi64x(static_cast<long long>(b.genreMask));
+    const __m256 genreCount = _mm256_set1_ps(b.genreCount);
+    const __m256i typeId = _mm256_set1_epi32(b.typeId);
+    const __m256 episode = _mm256_set1_ps(b.episode);
+    const __m256 rating = _mm256_set1_ps(b.rating);
+    const __m256 member = _mm256_set1_ps(b.member);
+
+    size_t count = 0;
+    size_t j = begin;
+    for (; j + 8 <= end; j += 8) {
+        // Popcounts of the eight intersections land in the low half of 64-bit lanes
+        // [a0 a1 a2 a3] and [b0 b1 b2 b3]; gather them as eight 32-bit lanes in order
+        const __m256i* masks = reinterpret_cast<const __m256i*>(b.genreMasks + j);
+        __m256i low = popcount64(_mm256_and_si256(_mm256_loadu_si256(masks), genreMask));
+        __m256i high = popcount64(_mm256_and_si256(_mm256_loadu_si256(masks + 1), genreMask));
+        __m256 packed = _mm256_shuffle_ps(_mm256_castsi256_ps(low), _mm256_castsi256_ps(high), _MM_SHUFFLE(2, 0, 2, 0));
+        __m256 common = _mm256_cvtepi32_ps(_mm256_permute4x64_epi64(_mm256_castps_si256(packed), _MM_SHUFFLE(3, 1, 2, 0)));
+        __m256 genre = _mm256_div_ps(common, _mm256_max_ps(genreCount, _mm256_loadu_ps(b.genreCounts + j)));
+
+        __m256i types = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b.typeIds + j));
+        __m256 type = _mm256_and_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(types, typeId)), one);
+
+        __m256 episodes = _mm256_loadu_ps(b.episodes + j);
+        __m256 episodeSim = _mm256_sub_ps(one, _mm256_div_ps(_mm256_andnot_ps(sign, _mm256_sub_ps(episode, episodes)),
+                                                             _mm256_max_ps(episode, episodes)));
+        __m256 ratings = _mm256_loadu_ps(b.ratings + j);
+        __m256 ratingSim = _mm256_sub_ps(one, _mm256_div_ps(_mm256_andnot_ps(sign, _mm256_sub_ps(rating, ratings)), ten));
+        __m256 members = _mm256_loadu_ps(b.members + j);
+        __m256 memberSim = _mm256_sub_ps(one, _mm256_div_ps(_mm256_andnot_ps(sign, _mm256_sub_ps(member, members)),
+                                                            _mm256_max_ps(member, members)));
+
+        __m256 score = _mm256_mul_ps(_mm256_set1_ps(b.weights[0]), genre);
+        score = _mm256_add_ps(score, _mm256_mul_ps(_mm256_set1_ps(b.weights[1]), type));
+        score = _mm256_add_ps(score, _mm256_mul_ps(_mm256_set1_ps(b.weights[2]), episodeSim));
+        score = _mm256_add_ps(score, _mm256_mul_ps(_mm256_set1_ps(b.weights[3]), ratingSim));
+        score = _mm256_add_ps(score, _mm256_mul_ps(_mm256_set1_ps(b.weights[4]), memberSim));
+
+        if (scores)
+            _mm256_storeu_ps(scores + j, score);
+        if (selected) {
+            unsigned bits = static_cast<unsigned>(_mm256_movemask_ps(_mm256_cmp_ps(score, limit, _CMP_GE_OQ)));
+            while (bits != 0) {
+                selected[count++] = static_cast<uint32_t>(j + __builtin_ctz(bits));
+                bits &= bits - 1;
+            }
+        }
+    }
+    return count + scoreScalar(b, j, end, threshold, scores, selected ? selected + count : nullptr);
+}
+
+#endif // SIMILARITY_KERNEL_X86
+
+} // namespace similarity_detail
+
+/**
+ *  Batched `calculateSimilarity`: scores one anime against a contiguous
+ *  range of others.
+ *
+ *  The attributes are copied once into flat columns (genre masks and
+ *  counts, type ids, and `float` episodes, ratings and members) and scored
+ *  8 (AVX2) or 4 (SSE2) candidates at a time in single precision. Pairs
+ *  without episodes or members give NaN, as in `calculateSimilarity`, and
+ *  are never selected.
+ *
+ *  Scores agree with `calculateSimilarity` within `tolerance()` (1e-6 for
+ *  weights that add up to 1). Callers that need the exact edge set use the
+ *  kernel as a filter: they select a little below the threshold (`buildGraph`
+ *  uses `threshold - 2 * tolerance()`, which also covers rounding the
+ *  threshold to `float`) and confirm the candidates with
+ *  `calculateSimilarity`.
+ */
+class SimilarityKernel {
+public:
+
+    /**
+     *  Builds the columns.
+     *
+     *  @param[in]  animes      The animes, indexed as in the graph.
+     *  @param[in]  weights     The weights of `calculateSimilarity`.
+     *  @param[in]  level       The instruction set to use.
+     */
+    explicit SimilarityKernel(const std::vector<Anime>& animes, const SimilarityWeights& weights = SimilarityWeights(),
+                              SimilarityLevel level = bestSimilarityLevel())
+        : level_(level)
+    {
+        reserve(animes.size());
+        std::unordered_map<std::string_view, int32_t> types;
+        for (const Anime& anime : animes)
+            append(anime, types);
+        setWeights(weights);
+    }
+
+    /**
+     *  Copies the columns of another kernel in another order: index `k` of
+     *  the copy is index `order[k]` of `source`, so animes scattered in the
+     *  catalog can be scored as a contiguous range.
+     *
+     *  @param[in]  source  The kernel to copy.
+     *  @param[in]  order   The indices of `source` to copy, in the new order.
+     */
+    SimilarityKernel(const SimilarityKernel& source, const std::vector<uint32_t>& order)
+        : tolerance_(source.tolerance_), level_(source.level_)
+    {
+        reserve(order.size());
+        for (uint32_t index : order) {
+            genreMasks_.push_back(source.genreMasks_[index]);
+            genreCounts_.push_back(source.genreCounts_[index]);
+            typeIds_.push_back(source.typeIds_[index]);
+            episodes_.push_back(source.episodes_[index]);
+            ratings_.push_back(source.ratings_[index]);
+            members_.push_back(source.members_[index]);
+        }
+        std::copy(source.weights_, source.weights_ + 5, weights_);
+    }
+
+    /**
+     *  Returns the number of animes.
+     */
+    size_t size() const
+    {
+        return episodes_.size();
+    }
+
+    /**
+     *  Returns the largest difference between a score and
+     *  `calculateSimilarity` of the same pair.
+     */
+    float tolerance() const
+    {
+        return tolerance_;
+    }
+
+    /**
+     *  Scores anime `a` against animes `begin` to `end - 1`.
+     *
+     *  @param[out] scores  Indexed by anime: `scores[j]` is written for
+     *                      every `j` in the range.
+     */
+    void score(size_t a, size_t begin, size_t end, float* scores) const
+    {
+        run(a, begin, end, 0.0f, scores, nullptr);
+    }
+
+    /**
+     *  Finds the animes from `begin` to `end - 1` whose score against anime
+     *  `a` is at least `threshold`.
+     *
+     *  @param[out] selected    Room for `end - begin` indices. The selected
+     *                          animes are written in increasing order.
+     *
+     *  @return The number of selected animes.
+     */
+    size_t select(size_t a, size_t begin, size_t end, float threshold, uint32_t* selected) const
+    {
+        return run(a, begin, end, threshold, nullptr, selected);
+    }
+
+    /**
+     *  Keeps the animes of a list whose score against anime `a` is at least
+     *  `threshold`. Scored one by one: for long contiguous ranges the other
+     *  overload is faster.
+     *
+     *  @param[in]  candidates  The animes to score.
+     *  @param[out] selected    Room for `count` indices; may be `candidates`.
+     *                          The kept animes are written in list order.
+     *
+     *  @return The number of selected animes.
+     */
+    size_t select(size_t a, const uint32_t* candidates, size_t count, float threshold, uint32_t* selected) const
+    {
+        similarity_detail::Block block = blockOf(a);
+        size_t kept = 0;
+        for (size_t k = 0; k < count; ++k) {
+            uint32_t j = candidates[k];
+            if (similarity_detail::scoreOne(block, j) >= threshold)
+                selected[kept++] = j;
+        }
+        return kept;
+    }
+
+private:
+
+    void reserve(size_t count)
+    {
+        genreMasks_.reserve(count);
+        genreCounts_.reserve(count);
+        typeIds_.reserve(count);
+        episodes_.reserve(count);
+        ratings_.reserve(count);
+        members_.reserve(count);
+    }
+
+    void append(const Anime& anime, std::unordered_map<std::string_view, int32_t>& types)
+    {
+        genreMasks_.push_back(anime.genreMask);
+        genreCounts_.push_back(static_cast<float>(genreCount(anime.genreMask)));
+        typeIds_.push_back(types.emplace(anime.type, static_cast<int32_t>(types.size())).first->second);
+        episodes_.push_back(static_cast<float>(anime.episodes));
+        ratings_.push_back(anime.rating);
+        members_.push_back(static_cast<float>(anime.members));
+    }
+
+    void setWeights(const SimilarityWeights& weights)
+    {
+        const double all[5] = { weights.genre, weights.type, weights.episodes, weights.rating, weights.members };
+        double total = 0;
+        for (unsigned k = 0; k < 5; ++k) {
+            weights_[k] = static_cast<float>(all[k]);
+            total += std::abs(all[k]);
+        }
+        // A few float roundings per term, scaled by the weights
+        tolerance_ = 1e-6f * static_cast<float>(std::max(1.0, total));
+    }
+
+    similarity_detail::Block blockOf(size_t a) const
+    {
+        return { genreMasks_.data(), genreCounts_.data(), typeIds_.data(),
+                 episodes_.data(), ratings_.data(), members_.data(),
+                 genreMasks_[a], genreCounts_[a], typeIds_[a],
+                 episodes_[a], ratings_[a], members_[a],
+                 { weights_[0], weights_[1], weights_[2], weights_[3], weights_[4] } };
+    }
+
+    size_t run(size_t a, size_t begin, size_t end, float threshold, float* scores, uint32_t* selected) const
+    {
+        similarity_detail::Block block = blockOf(a);
+        switch (level_) {
+#ifdef SIMILARITY_KERNEL_X86
+            case SimilarityLevel::AVX2:
+                return similarity_detail::scoreAVX2(block, begin, end, threshold, scores, selected);
+            case SimilarityLevel::SSE2:
+                return similarity_detail::scoreSSE2(block, begin, end, threshold, scores, selected);
+#endif
+            default:
+                return similarity_detail::scoreScalar(block, begin, end, threshold, scores, selected);
+        }
+    }
+
+    std::vector<uint64_t> genreMasks_;      /**< Genre mask column. */
+    std::vector<float> genreCounts_;        /**< Genres of each anime. */
+    std::vector<int32_t> typeIds_;          /**< Type column, as ids local to the kernel. */
+    std::vector<float> episodes_;           /**< Episodes column. */
+    std::vector<float> ratings_;            /**< Rating column. */
+    std::vector<float> members_;            /**< Members column. */
+    float weights_[5];                      /**< `SimilarityWeights`, in declaration order. */
+    float tolerance_;                       /**< See `tolerance()`. */
+    SimilarityLevel level_;                 /**< Instruction set in use. */
+};
+
+#endif // SIMILARITY_KERNEL_HPP
@@ -0,0 +1,172 @@
+#ifndef STRING_ARENA_HPP
+#define STRING_ARENA_HPP
+
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <string_view>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+/**
+ *  Append-only storage for strings.
+ *
+ *  Strings are copied back to back into large blocks and handed out as
+ *  `std::string_view`. Blocks are never moved or freed before the arena
+ *  itself, so the views stay valid for the lifetime of the arena (also
+ *  across moves of the arena object). A moved-from arena is empty and can
+ *  be used again.
+ */
+class StringArena {
+public:
+
+    /**
+     *  Creates an empty arena.
+     *
+     *  @param[in]  blockSize   Size of each storage block in bytes.
+     */
+    explicit StringArena(size_t blockSize = 64 * 1024) : blockSize_(blockSize) {}
+
+    StringArena(const StringArena&) = delete;
+    StringArena& operator=(const StringArena&) = delete;
+    /**
+     *  Takes the blocks of another arena, so views into it stay valid. The
+     *  other arena is left empty. Must not race with `intern` on either
+     *  arena.
+     */
+    StringArena(StringArena&& other) noexcept
+        : blockSize_(other.blockSize_)
+    {
+        take(other);
+    }
+
+    /**
+     *  Releases the blocks of this arena and takes those of another one;
+     *  see the move constructor.
+     */
+    StringArena& operator=(StringArena&& other) noexcept
+    {
+        if (this != &other) {
+            blockSize_ = other.blockSize_;
+            take(other);
+        }
+        return *this;
+    }
+
+    /**
+     *  Returns the arena shared by every `Anime` object. It is only used
+     *  through `intern` and never released.
+     *
+     *  @note It only grows: every distinct title and type label an `Anime`
+     *        is built with stays until the program exits, including the
+     *        new titles of rows retitled by `applyDelta`. The catalog keeps
+     *        its own arena (`AnimeCatalog`), which is released with it.
+     */
+    static StringArena& global()
+    {
+        static StringArena arena;
+        return arena;
+    }
+
+    /**
+     *  Copies a string into the arena. Not thread-safe.
+     *
+     *  @param[in]  text    The string to copy.
+     *
+     *  @return A view of the copy.
+     */
+    std::string_view store(std::string_view text)
+    {
+        if (text.empty())
+            return std::string_view();
+
+        char* copy;
+        if (text.size() > blockSize_) {
+            // Oversized strings get a block of their own
+            blocks_.emplace_back(new char[text.size()]);
+            reserved_ += text.size();
+            copy = blocks_.back().get();
+        } else {
+            if (current_ == nullptr || blockSize_ - used_ < text.size()) {
+                blocks_.emplace_back(new char[blockSize_]);
+                reserved_ += blockSize_;
+                current_ = blocks_.back().get();
+                used_ = 0;
+            }
+            copy = current_ + used_;
+            used_ += text.size();
+        }
+
+        std::memcpy(copy, text.data(), text.size());
+        stored_ += text.size();
+        return std::string_view(copy, text.size());
+    }
+
+    /**
+     *  Returns the stored copy of a string, copying it into the arena only
+     *  the first time it is seen. Thread-safe.
+     *
+     *  @param[in]  text    The string to intern.
+     *
+     *  @return A view of the unique copy.
+     */
+    std::string_view intern(std::string_view text)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+
+        auto it = interned_.find(text);
+        if (it != interned_.end())
+            return *it;
+
+        std::string_view copy = store(text);
+        interned_.insert(copy);
+        return copy;
+    }
+
+    /**
+     *  Returns the number of string bytes stored in the arena.
+     */
+    size_t bytes_used() const
+    {
+        return stored_;
+    }
+
+    /**
+     *  Returns the number of bytes allocated for blocks.
+     */
+    size_t bytes_reserved() const
+    {
+        return reserved_;
+    }
+
+private:
+
+    size_t blockSize_;                                  /**< Size of a regular block. */
+    std::vector<std::unique_ptr<char[]>> blocks_;       /**< Storage blocks. */
+    char* current_{nullptr};                            /**< Block that receives new strings. */
+    size_t used_{0};                                    /**< Bytes used in the current block. */
+    size_t stored_{0};                                  /**< Total bytes stored. */
+    size_t reserved_{0};                                /**< Total bytes allocated. */
+
+    std::unordered_set<std::string_view> interned_;     /**< Views of the interned strings. */
+    std::mutex mutex_;                                  /**< Guards `intern`; every arena has its own. */
+
+    /**
+     *  Moves the contents of `other` into this arena and leaves `other`
+     *  empty.
+     */
+    void take(StringArena& other)
+    {
+        blocks_ = std::move(other.blocks_);
+        interned_ = std::move(other.interned_);
+        other.blocks_.clear();
+        other.interned_.clear();
+        current_ = std::exchange(other.current_, nullptr);
+        used_ = std::exchange(other.used_, 0);
+        stored_ = std::exchange(other.stored_, 0);
+        reserved_ = std::exchange(other.reserved_, 0);
+    }
+};
+
+#endif // STRING_ARENA_HPP
@@ -2,19 +2,21 @@
 #define TRIE_HPP
 
 #include <string>
+#include <string_view>
 #include <unordered_map>
 #include <vector>
 #include <iostream>
 #include <algorithm> // Para transformar a minúsculas
-#include "../anime.hpp"
+#include <cctype>
+#include "animeCatalog.hpp"
 
 class TrieNode {
 public:
     std::unordered_map<char, TrieNode*> children;
     bool isEndOfWord;
-    Anime* anime; // Puntero al objeto Anime correspondiente
+    AnimeHandle anime; // Handle del anime correspondiente en el AnimeCatalog
 
-    TrieNode() : isEndOfWord(false), anime(nullptr) {}
+    TrieNode() : isEndOfWord(false), anime(0) {}
 };
 
 class Trie {
@@ -22,7 +24,7 @@ private:
     TrieNode* root;
 
     // Función auxiliar para recopilar sugerencias recursivamente
-    void collectSuggestions(TrieNode* node, const std::string& prefix, std::vector<std::pair<std::string, Anime*>>& suggestions) const {
+    void collectSuggestions(TrieNode* node, const std::string& prefix, std::vector<std::pair<std::string, AnimeHandle>>& suggestions) const {
         if (node->isEndOfWord) {
             suggestions.emplace_back(prefix, node->anime);
         }
@@ -46,11 +48,11 @@ public:
     }
 
     // Insertar un nombre en el Trie
-    void insert(const std::string& name, Anime* anime) {
+    void insert(std::string_view name, AnimeHandle anime) {
         TrieNode* current = root;
         for (char c : name) {
             // Convertir a minúsculas para una búsqueda no sensible a mayúsculas
-            c = std::tolower(c);
+            c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
             if (current->children.find(c) == current->children.end()) {
                 current->children[c] = new TrieNode();
             }
@@ -60,37 +62,54 @@ public:
         current->anime = anime;
     }
 
+    // Eliminar un nombre del Trie (los nodos se conservan, sólo deja de ser palabra)
+    bool remove(std::string_view name) {
+        TrieNode* current = root;
+        for (char c : name) {
+            c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+            auto it = current->children.find(c);
+            if (it == current->children.end()) {
+                return false;
+            }
+            current = it->second;
+        }
+        bool found = current->isEndOfWord;
+        current->isEndOfWord = false;
+        return found;
+    }
+
     // Obtener sugerencias basadas en un prefijo
-    std::vector<std::pair<std::string, Anime*>> getSuggestions(const std::string& prefix) const {
+    std::vector<std::pair<std::string, AnimeHandle>> getSuggestions(const std::string& prefix) const {
         TrieNode* current = root;
         std::string lowerPrefix;
         for (char c : prefix) {
-            c = std::tolower(c);
+            c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
             lowerPrefix += c;
             if (current->children.find(c) == current->children.end()) {
                 return {}; // No se encontraron sugerencias
             }
             current = current->children[c];
         }
-        std::vector<std::pair<std::string, Anime*>> suggestions;
+        std::vector<std::pair<std::string, AnimeHandle>> suggestions;
         collectSuggestions(current, prefix, suggestions);
         return suggestions;
     }
 
-    // Buscar un anime por nombre exacto
-    Anime* search(const std::string& name) const {
+    // Buscar un anime por nombre exacto (devuelve false si no existe)
+    bool search(const std::string& name, AnimeHandle& anime) const {
         TrieNode* current = root;
         for (char c : name) {
-            c = std::tolower(c);
+            c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
             if (current->children.find(c) == current->children.end()) {
-                return nullptr;
+                return false;
             }
             current = current->children[c];
         }
         if (current->isEndOfWord) {
-            return current->anime;
+            anime = current->anime;
+            return true;
         }
-        return nullptr;
+        return false;
     }
 };
 
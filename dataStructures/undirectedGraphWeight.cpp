@@ -1,51 +1,453 @@
 #include "undirectedGraphWeight.hpp"
-#include <set>
-#include <iterator>
+#include "candidateIndex.hpp"
+#include "lshIndex.hpp"
+#include <atomic>
+#include <thread>
 
-// Función para calcular la similitud entre dos animes
-long double calculateSimilarity(const Anime& a, const Anime& b) {
-    // Similitud basada en géneros
-    std::vector<std::string> commonGenres;
-    std::set_intersection(a.genres.begin(), a.genres.end(), b.genres.begin(), b.genres.end(), std::back_inserter(commonGenres));
-    long double genreSimilarity = static_cast<long double>(commonGenres.size()) / std::max(a.genres.size(), b.genres.size());
+// Filtro de pares de una fila. El índice de géneros (CandidateIndex) descarta los pares que
+// no pueden llegar al umbral y el kernel en float descarta los que quedan claramente por debajo;
+// los que pasan son un superconjunto de los arcos y se confirman con calculateSimilarity.
+class RowFilter {
+public:
+    template <typename Weight>
+    RowFilter(const std::vector<Anime>& vertices, Weight threshold, const SimilarityWeights& weights)
+        : kernel_(vertices, weights), index_(vertices, weights, static_cast<double>(threshold)),
+          // Ningún par con similitud >= threshold queda bajo este umbral en float
+          threshold_(static_cast<float>(threshold) - 2 * kernel_.tolerance()) {}
+
+    // Escribe en `candidates` (con lugar para V índices), en orden creciente, los j >= begin
+    // que pueden llegar al umbral con i. Puede incluir a i.
+    size_t select(size_t i, size_t begin, CandidateIndex::Scratch& scratch, std::vector<uint32_t>& candidates) const {
+        size_t rows = kernel_.size();
+        // Recorrer una entrada del índice cuesta varias veces más que un par del kernel sobre
+        // el rango contiguo, así que el índice solo se usa cuando recorre mucho menos
+        if (index_.prunes() && index_.cost(i, begin) * INDEX_COST < rows - begin) {
+            size_t count = index_.row(i, begin, scratch, candidates.data());
+            return kernel_.select(i, candidates.data(), count, threshold_, candidates.data());
+        }
+        return kernel_.select(i, begin, rows, threshold_, candidates.data());
+    }
+
+private:
+    static constexpr size_t INDEX_COST = 16; // Pares del kernel por entrada recorrida del índice
+    SimilarityKernel kernel_;
+    CandidateIndex index_;
+    float threshold_;
+};
+
+// Función para calcular la similitud entre dos animes. T es el tipo en el que se hacen
+// las cuentas; con long double el resultado es el de siempre.
+template <typename T>
+T calculateSimilarity(const Anime& a, const Anime& b, const SimilarityWeights& weights) {
+    // Similitud basada en géneros (intersección de las máscaras)
+    unsigned commonGenres = genreCount(a.genreMask & b.genreMask);
+    T genreSimilarity = static_cast<T>(commonGenres) / std::max(genreCount(a.genreMask), genreCount(b.genreMask));
 
     // Similitud basada en tipo
-    long double typeSimilarity = (a.type == b.type) ? 1.0 : 0.0;
+    T typeSimilarity = (a.type == b.type) ? T(1) : T(0);
 
     // Similitud basada en episodios (normalización)
-    long double episodeDiff = std::abs(a.episodes - b.episodes);
-    long double episodeSimilarity = 1.0 - (episodeDiff / std::max(a.episodes, b.episodes));
+    T episodeDiff = std::abs(a.episodes - b.episodes);
+    T episodeSimilarity = T(1) - (episodeDiff / std::max(a.episodes, b.episodes));
 
     // Similitud basada en rating
-    long double ratingDiff = std::abs(a.rating - b.rating);
-    long double ratingSimilarity = 1.0 - (ratingDiff / 10.0); // Normalizado entre 0 y 1
+    T ratingDiff = std::abs(a.rating - b.rating);
+    T ratingSimilarity = T(1) - (ratingDiff / T(10)); // Normalizado entre 0 y 1
 
     // Similitud basada en miembros
-    long double memberDiff = std::abs(a.members - b.members);
-    long double memberSimilarity = 1.0 - (memberDiff / std::max(a.members, b.members));
+    T memberDiff = std::abs(a.members - b.members);
+    T memberSimilarity = T(1) - (memberDiff / std::max(a.members, b.members));
 
-    // Combinar las similitudes (puedes ajustar los pesos)
-    long double similarity = (0.4 * genreSimilarity) +
-                        (0.2 * typeSimilarity) +
-                        (0.15 * episodeSimilarity) +
-                        (0.15 * ratingSimilarity) +
-                        (0.1 * memberSimilarity);
+    // Combinar las similitudes (los pesos se ajustan en SimilarityWeights)
+    T similarity = (T(weights.genre) * genreSimilarity) +
+                   (T(weights.type) * typeSimilarity) +
+                   (T(weights.episodes) * episodeSimilarity) +
+                   (T(weights.rating) * ratingSimilarity) +
+                   (T(weights.members) * memberSimilarity);
 
     return similarity;
 }
 
-void buildGraph(UndirectedGraphWeight& graph, long double threshold) {
-    // Agregar arcos basados en similitud
+// Agrega a `batch` los arcos (i, j) con j > i de la fila i, en orden de j. Solo se evalúan
+// los candidatos de RowFilter (`candidates` debe tener lugar para V índices), así que los
+// arcos y sus pesos son exactamente los de la versión par por par.
+template <typename Weight, typename Storage>
+static void appendRowEdges(const AnimeGraph<Weight, Storage>& graph, const RowFilter& filter, size_t i,
+                           Weight threshold, const SimilarityWeights& weights, CandidateIndex::Scratch& scratch,
+                           std::vector<uint32_t>& candidates,
+                           std::vector<typename AnimeGraph<Weight, Storage>::edge_type>& batch) {
+    const std::vector<Anime>& vertices = graph.vertices();
+    if (!graph.is_alive(i)) return;
+    size_t count = filter.select(i, i + 1, scratch, candidates);
+    for (size_t k = 0; k < count; ++k) {
+        size_t j = candidates[k];
+        if (!graph.is_alive(j)) continue;
+        Weight similarity = calculateSimilarity<Weight>(vertices[i], vertices[j], weights);
+        if (similarity >= threshold) {
+            Weight weight = Weight(1) - similarity; // Ponderación inversa a la similitud
+            if (weight > 0) {
+                batch.push_back({ uint32_t(i), uint32_t(j), Storage::encode(weight) });
+            }
+        }
+    }
+}
+
+template <typename Weight, typename Storage>
+void buildGraph(AnimeGraph<Weight, Storage>& graph, typename AnimeGraph<Weight, Storage>::weight_type threshold,
+                const SimilarityWeights& weights) {
+    using Graph = AnimeGraph<Weight, Storage>;
+    std::vector<typename Graph::edge_type> batch;
+    RowFilter filter(graph.vertices(), threshold, weights);
+    CandidateIndex::Scratch scratch;
+    std::vector<uint32_t> candidates(graph.vertices().size());
+
+    // Agregar arcos basados en similitud. El ciclo i < j ya garantiza pares
+    // únicos y sin lazos, así que se insertan todos juntos al final.
+    // Los vértices eliminados (lápidas) se saltan.
     for (size_t i = 0; i < graph.vertices().size(); ++i) {
-        for (size_t j = i + 1; j < graph.vertices().size(); ++j) {
-            long double similarity = calculateSimilarity(graph.vertices()[i], graph.vertices()[j]);
+        appendRowEdges(graph, filter, i, threshold, weights, scratch, candidates, batch);
+    }
+    graph.add_edges(std::move(batch));
+    return;
+}
+
+// Reparte las filas [0, rows) en bloques de `chunk` filas que `threads` hilos toman de un
+// contador atómico, así las filas caras no dejan hilos ociosos. Llama a work(worker, c)
+// para cada bloque c; el hilo que llama también trabaja (worker 0).
+template <typename Work>
+static void parallelRows(size_t rows, unsigned threads, size_t chunk, Work work) {
+    const size_t chunks = (rows + chunk - 1) / chunk;
+    std::atomic<size_t> next{0};
+
+    auto run = [&](unsigned worker) {
+        for (size_t c = next.fetch_add(1, std::memory_order_relaxed); c < chunks;
+             c = next.fetch_add(1, std::memory_order_relaxed)) {
+            work(worker, c);
+        }
+    };
+
+    std::vector<std::thread> workers;
+    for (unsigned w = 1; w < threads; ++w)
+        workers.emplace_back(run, w);
+    run(0);
+    for (auto& worker : workers)
+        worker.join();
+}
+
+// Unos 32 bloques por hilo: suficientes para balancear sin pelear por el contador
+static size_t rowChunk(size_t rows, unsigned threads) {
+    return std::max<size_t>(1, rows / (size_t(threads) * 32));
+}
+
+// Versión paralela de buildGraph. Las filas se reparten con parallelRows (la fila i cuesta
+// V - i pares, así que un reparto fijo queda desbalanceado). Cada hilo guarda sus arcos en su
+// propio buffer y anota dónde empieza cada bloque; al final los bloques se copian en orden de
+// fila, así que la lista de arcos es idéntica a buildGraph.
+template <typename Weight, typename Storage>
+void buildGraphParallel(AnimeGraph<Weight, Storage>& graph, typename AnimeGraph<Weight, Storage>::weight_type threshold,
+                        unsigned threads, const SimilarityWeights& weights) {
+    using Edge = typename AnimeGraph<Weight, Storage>::edge_type;
+    const size_t rows = graph.vertices().size();
+    threads = std::max(1u, threads);
+    const size_t chunk = rowChunk(rows, threads);
+
+    struct Slice {
+        unsigned worker;
+        size_t begin, end;      // Rango en el buffer del hilo
+    };
+    std::vector<std::vector<Edge>> buffers(threads);
+    std::vector<CandidateIndex::Scratch> scratches(threads);
+    std::vector<std::vector<uint32_t>> candidates(threads, std::vector<uint32_t>(rows));
+    std::vector<Slice> slices((rows + chunk - 1) / chunk);
+    RowFilter filter(graph.vertices(), threshold, weights);
+
+    parallelRows(rows, threads, chunk, [&](unsigned worker, size_t c) {
+        std::vector<Edge>& buffer = buffers[worker];
+        size_t begin = buffer.size();
+        for (size_t i = c * chunk; i < std::min(rows, (c + 1) * chunk); ++i) {
+            appendRowEdges(graph, filter, i, threshold, weights, scratches[worker], candidates[worker], buffer);
+        }
+        slices[c] = { worker, begin, buffer.size() };
+    });
+
+    // Unir los bloques en orden de fila
+    size_t total = 0;
+    for (const auto& buffer : buffers)
+        total += buffer.size();
+    std::vector<Edge> batch;
+    batch.reserve(total);
+    for (const Slice& slice : slices) {
+        const std::vector<Edge>& buffer = buffers[slice.worker];
+        batch.insert(batch.end(), buffer.begin() + slice.begin, buffer.begin() + slice.end);
+    }
+    buffers.clear();
+    graph.add_edges(std::move(batch));
+}
+
+// Los K vecinos más similares de i (sin i, lápidas, NaN ni pares idénticos, que no dan arco),
+// como pares (similitud, j) de mejor a peor; los empates se resuelven por índice menor.
+// El kernel en float puntúa la fila entera y un heap acotado da el K-ésimo mejor puntaje entre
+// los pares que seguro dan arco (puntaje < 1 - 2 * tolerance()); solo los que quedan a
+// 2 * tolerance() de él pueden estar entre los K de verdad, y esos se ordenan con
+// calculateSimilarity en otro heap acotado.
+template <typename Weight, typename Storage>
+static void nearestNeighbors(const AnimeGraph<Weight, Storage>& graph, const SimilarityKernel& kernel, size_t i,
+                             size_t k, const SimilarityWeights& weights, std::vector<float>& scores,
+                             std::vector<std::pair<Weight, uint32_t>>& nearest) {
+    const std::vector<Anime>& vertices = graph.vertices();
+    nearest.clear();
+    if (!graph.is_alive(i) || k == 0) return;
+    kernel.score(i, 0, vertices.size(), scores.data());
+
+    // Primero el puntaje: casi todos los pares quedan por debajo del K-ésimo mejor
+    std::priority_queue<float, std::vector<float>, std::greater<float>> best;
+    const float limit = 1.0f - 2 * kernel.tolerance();
+    float worst = -std::numeric_limits<float>::infinity();
+    for (size_t j = 0; j < vertices.size(); ++j) {
+        float score = scores[j];
+        if (!(score > worst) || !(score < limit) || j == i || !graph.is_alive(j)) continue;
+        if (best.size() == k) best.pop();
+        best.push(score);
+        if (best.size() == k) worst = best.top();
+    }
+    float cutoff = best.size() < k ? -std::numeric_limits<float>::infinity() : best.top() - 2 * kernel.tolerance();
+
+    // Mejor primero: mayor similitud y, a igual similitud, menor índice. La cima es el peor.
+    auto better = [](const std::pair<Weight, uint32_t>& a, const std::pair<Weight, uint32_t>& b) {
+        return a.first > b.first || (a.first == b.first && a.second < b.second);
+    };
+    for (size_t j = 0; j < vertices.size(); ++j) {
+        if (!(scores[j] >= cutoff) || j == i || !graph.is_alive(j)) continue;
+        // Mismo orden de argumentos que buildGraph, así el peso es idéntico
+        Weight similarity = calculateSimilarity<Weight>(vertices[std::min(i, j)], vertices[std::max(i, j)], weights);
+        if (!(Weight(1) - similarity > 0)) continue;
+        std::pair<Weight, uint32_t> entry{ similarity, uint32_t(j) };
+        if (nearest.size() < k) {
+            nearest.push_back(entry);
+            std::push_heap(nearest.begin(), nearest.end(), better);
+        } else if (better(entry, nearest.front())) {
+            std::pop_heap(nearest.begin(), nearest.end(), better);
+            nearest.back() = entry;
+            std::push_heap(nearest.begin(), nearest.end(), better);
+        }
+    }
+    std::sort_heap(nearest.begin(), nearest.end(), better);
+}
+
+// Grafo de los K vecinos más cercanos: cada vértice se une con sus K animes más similares
+// (ver nearestNeighbors) y el resultado se simetriza, así que hay entre V·K/2 y V·K arcos y
+// un vértice puede terminar con más de K vecinos. Las filas se reparten entre hilos como en
+// buildGraphParallel; cada fila se escribe en su propio lugar y los arcos se insertan
+// ordenados, así que el resultado no depende de la cantidad de hilos.
+template <typename Weight, typename Storage>
+void buildGraphTopK(AnimeGraph<Weight, Storage>& graph, size_t k, unsigned threads, const SimilarityWeights& weights) {
+    using Edge = typename AnimeGraph<Weight, Storage>::edge_type;
+    const std::vector<Anime>& vertices = graph.vertices();
+    const size_t rows = vertices.size();
+    threads = std::max(1u, threads);
+    const size_t chunk = rowChunk(rows, threads);
+
+    SimilarityKernel kernel(vertices, weights);
+    std::vector<std::vector<std::pair<Weight, uint32_t>>> nearest(rows);
+    std::vector<std::vector<float>> scores(threads, std::vector<float>(rows));
+
+    parallelRows(rows, threads, chunk, [&](unsigned worker, size_t c) {
+        for (size_t i = c * chunk; i < std::min(rows, (c + 1) * chunk); ++i) {
+            nearestNeighbors(graph, kernel, i, k, weights, scores[worker], nearest[i]);
+        }
+    });
+
+    // Simetrizar: el arco {i, j} está si j es de los K de i o i de los K de j
+    std::vector<Edge> batch;
+    for (size_t i = 0; i < rows; ++i) {
+        for (const auto& [similarity, j] : nearest[i]) {
+            uint32_t a = uint32_t(std::min<size_t>(i, j)), b = uint32_t(std::max<size_t>(i, j));
+            batch.push_back({ a, b, Storage::encode(Weight(1) - similarity) });
+        }
+        nearest[i] = {};
+    }
+    auto byPair = [](const Edge& x, const Edge& y) { return x.v1 < y.v1 || (x.v1 == y.v1 && x.v2 < y.v2); };
+    auto samePair = [](const Edge& x, const Edge& y) { return x.v1 == y.v1 && x.v2 == y.v2; };
+    std::sort(batch.begin(), batch.end(), byPair);
+    batch.erase(std::unique(batch.begin(), batch.end(), samePair), batch.end());
+    graph.add_edges(std::move(batch));
+}
+
+// Grafo aproximado para catálogos grandes: solo se evalúan los pares que LshIndex lista. Cada
+// banda copia las columnas del kernel en su orden, así cada ventana se puntúa como un rango
+// contiguo; como en RowFilter, el kernel descarta los pares que quedan claramente bajo el
+// umbral y el resto se confirma con calculateSimilarity (mismo orden de argumentos que
+// buildGraph), así que cada arco está también en el grafo exacto y con el mismo peso. Lo que
+// se pierde son los pares que ninguna banda lista (ver edgeRecall). Cada banda es un bloque de
+// parallelRows y los bloques se unen en orden de banda, así que el resultado no depende de la
+// cantidad de hilos. Devuelve la cantidad de pares puntuados (un par puede estar en varias bandas).
+template <typename Weight, typename Storage>
+size_t buildGraphLsh(AnimeGraph<Weight, Storage>& graph, typename AnimeGraph<Weight, Storage>::weight_type threshold,
+                     const LshParams& params, unsigned threads, const SimilarityWeights& weights) {
+    using Edge = typename AnimeGraph<Weight, Storage>::edge_type;
+    const std::vector<Anime>& vertices = graph.vertices();
+    threads = std::max(1u, threads);
+    const LshIndex index(vertices, params);
+    const SimilarityKernel catalog(vertices, weights);
+
+    std::vector<std::vector<Edge>> bands(index.bands());
+    std::vector<std::vector<uint32_t>> animes(threads), ends(threads);
+    std::vector<std::vector<uint32_t>> selected(threads, std::vector<uint32_t>(params.window));
+    std::vector<size_t> scored(threads, 0);
+
+    parallelRows(index.bands(), threads, 1, [&](unsigned worker, size_t band) {
+        const std::vector<uint32_t>& order = animes[worker];
+        index.band(unsigned(band), animes[worker], ends[worker]);
+        const SimilarityKernel kernel(catalog, order);
+        const float floor = static_cast<float>(threshold) - 2 * kernel.tolerance();
+
+        for (size_t p = 0; p < order.size(); ++p) {
+            size_t end = ends[worker][p];
+            uint32_t i = order[p];
+            if (end <= p + 1 || !graph.is_alive(i)) continue;
+            scored[worker] += end - p - 1;
+            size_t kept = kernel.select(p, p + 1, end, floor, selected[worker].data());
+            for (size_t k = 0; k < kept; ++k) {
+                uint32_t j = order[selected[worker][k]];
+                if (!graph.is_alive(j) || index.listedBefore(unsigned(band), i, j)) continue;
+                uint32_t a = std::min(i, j), b = std::max(i, j);
+                Weight similarity = calculateSimilarity<Weight>(vertices[a], vertices[b], weights);
+                if (similarity >= threshold) {
+                    Weight weight = Weight(1) - similarity;
+                    if (weight > 0) {
+                        bands[band].push_back({ a, b, Storage::encode(weight) });
+                    }
+                }
+            }
+        }
+    });
+
+    std::vector<Edge> batch;
+    for (auto& edges : bands) {
+        batch.insert(batch.end(), edges.begin(), edges.end());
+        edges = {};
+    }
+    graph.add_edges(std::move(batch));
+
+    size_t total = 0;
+    for (size_t count : scored)
+        total += count;
+    return total;
+}
+
+// Fracción de los arcos de `exact` que también están en `approximate` (1 si `exact` no tiene arcos)
+template <typename Weight, typename Storage>
+double edgeRecall(const AnimeGraph<Weight, Storage>& approximate, const AnimeGraph<Weight, Storage>& exact) {
+    std::vector<uint64_t> keys;
+    keys.reserve(approximate.edge_list().size());
+    for (const auto& e : approximate.edge_list())
+        keys.push_back(EdgeIndex::key(e.v1, e.v2));
+    std::sort(keys.begin(), keys.end());
+
+    size_t found = 0;
+    for (const auto& e : exact.edge_list())
+        found += std::binary_search(keys.begin(), keys.end(), EdgeIndex::key(e.v1, e.v2));
+    return exact.edge_list().empty() ? 1.0 : double(found) / double(exact.edge_list().size());
+}
+
+// Agrega los arcos de los vértices nuevos o modificados (índices en `changed`, sin arcos)
+// contra todo el grafo: O(ΔV·V) en lugar de O(V²). Los pares se evalúan en el mismo
+// orden que buildGraph, así que el resultado coincide arco por arco con una reconstrucción.
+template <typename Weight, typename Storage>
+void extendGraph(AnimeGraph<Weight, Storage>& graph, const std::vector<size_t>& changed,
+                 typename AnimeGraph<Weight, Storage>::weight_type threshold, const SimilarityWeights& weights) {
+    using Graph = AnimeGraph<Weight, Storage>;
+    const std::vector<Anime>& vertices = graph.vertices();
+    std::vector<bool> dirty(vertices.size(), false);
+    std::vector<typename Graph::edge_type> batch;
+    for (size_t index : changed) {
+        dirty[index] = true;
+    }
+    RowFilter filter(vertices, threshold, weights);
+    CandidateIndex::Scratch scratch;
+    std::vector<uint32_t> candidates(vertices.size());
+
+    for (size_t k = 0; k < vertices.size(); ++k) {
+        if (!dirty[k] || !graph.is_alive(k)) continue;
+        size_t count = filter.select(k, 0, scratch, candidates);
+        for (size_t c = 0; c < count; ++c) {
+            size_t j = candidates[c];
+            // Los pares entre dos vértices modificados se evalúan una sola vez
+            if (j == k || (dirty[j] && j < k) || !graph.is_alive(j)) continue;
+            size_t a = std::min(j, k), b = std::max(j, k);
+            Weight similarity = calculateSimilarity<Weight>(vertices[a], vertices[b], weights);
             if (similarity >= threshold) {
-                long double weight = 1.0 - similarity; // Ponderación inversa a la similitud
-		if (weight > 0) {
-		    graph.add_edge(graph.vertices()[i], graph.vertices()[j], weight);
-		}
+                Weight weight = Weight(1) - similarity;
+                if (weight > 0) {
+                    batch.push_back({ uint32_t(a), uint32_t(b), Storage::encode(weight) });
+                }
             }
         }
     }
-    return;
+    graph.add_edges(std::move(batch));
 }
+
+// Construye directamente el grafo comprimido (ver CompressedGraph) con los arcos que
+// buildGraph agregaría a `graph`. Cada fila se calcula y se comprime al momento, así que
+// la lista de arcos completa nunca está en memoria; a cambio cada par se evalúa dos veces.
+template <typename Weight, typename Storage>
+CompressedGraph buildCompressedGraph(const AnimeGraph<Weight, Storage>& graph,
+                                     typename AnimeGraph<Weight, Storage>::weight_type threshold, unsigned weightBits,
+                                     const SimilarityWeights& weights) {
+    const std::vector<Anime>& vertices = graph.vertices();
+    // Los pesos (1 - similitud) quedan en (0, 1 - umbral]
+    float maxWeight = std::max(float(std::min<Weight>(1, 1 - threshold)), std::numeric_limits<float>::min());
+    CompressedGraph compressed(maxWeight, weightBits);
+    std::vector<std::pair<uint32_t, float>> row;
+    RowFilter filter(vertices, threshold, weights);
+    CandidateIndex::Scratch scratch;
+    std::vector<uint32_t> candidates(vertices.size());
+
+    for (size_t i = 0; i < vertices.size(); ++i) {
+        row.clear();
+        size_t count = graph.is_alive(i) ? filter.select(i, 0, scratch, candidates) : 0;
+        for (size_t c = 0; c < count; ++c) {
+            size_t j = candidates[c];
+            if (j == i || !graph.is_alive(j)) continue;
+            // Mismo orden de argumentos que buildGraph, así el peso es idéntico
+            size_t a = std::min(i, j), b = std::max(i, j);
+            Weight similarity = calculateSimilarity<Weight>(vertices[a], vertices[b], weights);
+            if (similarity >= threshold) {
+                Weight weight = Weight(1) - similarity;
+                if (weight > 0) {
+                    row.emplace_back(uint32_t(j), float(weight));
+                }
+            }
+        }
+        compressed.append_row(row);
+    }
+    compressed.shrink_to_fit();
+    return compressed;
+}
+
+// Instancias usadas por el programa y por las pruebas de rendimiento. UndirectedGraphWeight
+// es AnimeGraph<long double, PlainWeights<float>>.
+#define INSTANTIATE_ANIME_GRAPH(WEIGHT, STORAGE)                                                                  \
+    template void buildGraph<WEIGHT, STORAGE>(AnimeGraph<WEIGHT, STORAGE>&, WEIGHT, const SimilarityWeights&);    \
+    template void buildGraphParallel<WEIGHT, STORAGE>(AnimeGraph<WEIGHT, STORAGE>&, WEIGHT, unsigned,              \
+                                                      const SimilarityWeights&);                                  \
+    template void buildGraphTopK<WEIGHT, STORAGE>(AnimeGraph<WEIGHT, STORAGE>&, size_t, unsigned,                  \
+                                                  const SimilarityWeights&);                                      \
+    template size_t buildGraphLsh<WEIGHT, STORAGE>(AnimeGraph<WEIGHT, STORAGE>&, WEIGHT, const LshParams&,        \
+                                                   unsigned, const SimilarityWeights&);                           \
+    template double edgeRecall<WEIGHT, STORAGE>(const AnimeGraph<WEIGHT, STORAGE>&,                               \
+                                                const AnimeGraph<WEIGHT, STORAGE>&);                              \
+    template void extendGraph<WEIGHT, STORAGE>(AnimeGraph<WEIGHT, STORAGE>&, const std::vector<size_t>&, WEIGHT, \
+                                               const SimilarityWeights&);                                         \
+    template CompressedGraph buildCompressedGraph<WEIGHT, STORAGE>(const AnimeGraph<WEIGHT, STORAGE>&, WEIGHT,    \
+                                                                   unsigned, const SimilarityWeights&);
+
+template long double calculateSimilarity<long double>(const Anime&, const Anime&, const SimilarityWeights&);
+template double calculateSimilarity<double>(const Anime&, const Anime&, const SimilarityWeights&);
+template float calculateSimilarity<float>(const Anime&, const Anime&, const SimilarityWeights&);
+
+INSTANTIATE_ANIME_GRAPH(long double, PlainWeights<float>)
+INSTANTIATE_ANIME_GRAPH(long double, PlainWeights<long double>)
+INSTANTIATE_ANIME_GRAPH(double, PlainWeights<double>)
+INSTANTIATE_ANIME_GRAPH(float, PlainWeights<float>)
+INSTANTIATE_ANIME_GRAPH(float, QuantizedWeights<uint16_t>)
@@ -2,82 +2,321 @@
 #define UNDIRECTED_GRAPH_WEIGHT_HPP
 
 #include "../anime.hpp"
+#include "compressedGraph.hpp"
+#include "edgeIndex.hpp"
+#include "lshIndex.hpp"
+#include "similarityKernel.hpp"
+#include "vertexIdIndex.hpp"
 #include <iostream>
+#include <optional>
 #include <stdexcept>
+#include <string_view>
 #include <vector>
 #include <unordered_map>
 #include <queue>
 #include <stack>
 #include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <thread>
+
+/**
+ *  Position of a vertex in `BasicUndirectedGraphWeight::vertices()`.
+ */
+using VertexHandle = uint32_t;
 
 /**
  *  Structure that defines an edge in a graph.
+ *
+ *  The vertices are positions in `BasicUndirectedGraphWeight::vertices()`;
+ *  the weight is in the form chosen by the storage policy of the graph.
+ */
+template <typename Stored>
+struct basic_edge {
+
+    uint32_t v1;        /**< Index of the first vertex of the edge. */
+    uint32_t v2;        /**< Index of the second vertex of the edge. */
+    Stored weight;      /**< The weight of the edge. */
+};
+
+/**
+ *  Edge of `UndirectedGraphWeight`, with a `float` weight.
+ */
+using edge = basic_edge<float>;
+
+/**
+ *  Keys of a vertex type: an integer id, unique within a graph, and a
+ *  title, which may repeat. Specialize it for every vertex type.
+ *
+ *  The graph indexes titles by `std::string_view`, so the characters must
+ *  not move while the vertex is in the graph (`Anime` titles live in the
+ *  `StringArena`).
  */
-struct edge {
+template <typename Vertex>
+struct VertexTraits;
 
-    Anime v1;          /**< The first vertex of the edge. */
-    Anime v2;          /**< The second vertex of the edge. */
-    long double weight;
+template <>
+struct VertexTraits<Anime> {
+    static int id(const Anime& anime) { return anime.anime_id; }
+    static std::string_view title(const Anime& anime) { return anime.name; }
+};
+
+/**
+ *  Storage policy that keeps weights as `Stored` values.
+ */
+template <typename Stored>
+struct PlainWeights {
+
+    using stored_type = Stored;
+
+    template <typename Weight>
+    static Stored encode(Weight weight) { return static_cast<Stored>(weight); }
+
+    template <typename Weight>
+    static Weight decode(Stored weight) { return static_cast<Weight>(weight); }
+};
+
+/**
+ *  Storage policy that keeps weights in [0, 1] as fixed point codes of an
+ *  unsigned integer type. Weights outside the range are clamped; the error
+ *  is at most `0.5 / max(Code)` (7.6e-6 for `uint16_t`).
+ */
+template <typename Code>
+struct QuantizedWeights {
+
+    using stored_type = Code;
+
+    template <typename Weight>
+    static Code encode(Weight weight)
+    {
+        Weight scaled = std::clamp(weight, Weight(0), Weight(1)) * Weight(std::numeric_limits<Code>::max());
+        return static_cast<Code>(std::lround(scaled));
+    }
+
+    template <typename Weight>
+    static Weight decode(Code weight)
+    {
+        return static_cast<Weight>(weight) / Weight(std::numeric_limits<Code>::max());
+    }
+};
+
+/**
+ *  An edge with its vertices resolved to vertex objects.
+ */
+template <typename Vertex, typename Weight>
+struct BasicEdgeRef {
+
+    const Vertex& v1;   /**< The first vertex of the edge. */
+    const Vertex& v2;   /**< The second vertex of the edge. */
+    Weight weight;      /**< The weight of the edge. */
+};
+
+/**
+ *  Read-only view over the edges of a graph. Vertex indices are resolved
+ *  to vertex objects and weights are decoded on access; nothing is copied.
+ *  The view is valid until the graph is modified.
+ */
+template <typename Vertex, typename Weight, typename Storage>
+class EdgeView {
+public:
+
+    using Edge = basic_edge<typename Storage::stored_type>;
+    using Ref = BasicEdgeRef<Vertex, Weight>;
+
+    class iterator {
+    public:
+
+        iterator(const Edge* e, const std::vector<Vertex>* vertices) : e_(e), vertices_(vertices) {}
+
+        Ref operator*() const
+        {
+            return { (*vertices_)[e_->v1], (*vertices_)[e_->v2], Storage::template decode<Weight>(e_->weight) };
+        }
+        iterator& operator++() { ++e_; return *this; }
+        bool operator==(const iterator& other) const { return e_ == other.e_; }
+        bool operator!=(const iterator& other) const { return e_ != other.e_; }
+
+    private:
+
+        const Edge* e_;
+        const std::vector<Vertex>* vertices_;
+    };
+
+    EdgeView(const std::vector<Edge>& edges, const std::vector<Vertex>& vertices)
+        : edges_(&edges), vertices_(&vertices) {}
+
+    iterator begin() const { return { edges_->data(), vertices_ }; }
+    iterator end() const { return { edges_->data() + edges_->size(), vertices_ }; }
+    size_t size() const { return edges_->size(); }
+    bool empty() const { return edges_->empty(); }
+    Ref operator[](size_t i) const { return *iterator(edges_->data() + i, vertices_); }
+
+private:
+
+    const std::vector<Edge>* edges_;
+    const std::vector<Vertex>* vertices_;
+};
+
+/**
+ *  Non-owning view over a contiguous range of values.
+ *
+ *  Stands in for `std::span`, which is not available in C++17.
+ */
+template <typename T>
+class Span {
+public:
+
+    Span() = default;
+    Span(const T* first, const T* last) : first_(first), last_(last) {}
+
+    const T* begin() const { return first_; }
+    const T* end() const { return last_; }
+    size_t size() const { return static_cast<size_t>(last_ - first_); }
+    bool empty() const { return first_ == last_; }
+    const T& operator[](size_t i) const { return first_[i]; }
+
+private:
+
+    const T* first_ = nullptr;
+    const T* last_ = nullptr;
 };
 
 /**
  *  Class that defines an undirected graph.
- * 
- *  The graph is represented as a collection of vertices and edges.
+ *
+ *  The graph is represented as a collection of vertices and edges. Traversals
+ *  use a compressed sparse row (CSR) copy of the adjacency: row `i` holds the
+ *  neighbors of vertex `i` in `adjacency_[rowStart_[i] .. rowStart_[i] +
+ *  rowSize_[i])` and their weights at the same positions of
+ *  `adjacencyWeights_`. `twin_` links every entry to the entry of the same
+ *  edge in the other row, so an edge is unlinked from both rows in O(1).
+ *  A row that runs out of capacity is moved to the end of the arrays; the
+ *  space it leaves is reclaimed by `compact()`.
+ *
+ *  `edgeIndex_` maps the pair of vertex indices of every edge to its position
+ *  in `edges_`, so edge lookups do not scan the edge list.
+ *
+ *  A vertex is identified by its id (`VertexTraits<Vertex>::id`) only.
+ *  `idIndex_` maps ids to the vertex index. Titles may repeat (anime.csv has
+ *  a few, and a projection without the name column leaves them all empty):
+ *  `titleIndex_` keeps every vertex with a non-empty title, and `find`
+ *  returns the first of them in `vertices()`.
+ *
+ *  Vertex indices (`VertexHandle`) are stable: removing a vertex leaves a
+ *  tombstone in `vertices()` instead of shifting the vertices after it, and
+ *  costs O(degree). Tombstones are dropped, and the vertices renumbered, only
+ *  by `compact()`.
+ *
+ *  @tparam Vertex  The vertex payload, with keys given by `VertexTraits`.
+ *  @tparam Weight  The type weights are computed and returned in.
+ *  @tparam Storage How weights are kept in the edges and rows
+ *                  (`PlainWeights`, `QuantizedWeights`).
  */
-class UndirectedGraphWeight {
+template <typename Vertex, typename Weight, typename Storage = PlainWeights<Weight>>
+class BasicUndirectedGraphWeight {
 public:
 
+    using vertex_type = Vertex;
+    using weight_type = Weight;
+    using storage_type = Storage;
+    using stored_weight = typename Storage::stored_type;
+    using edge_type = basic_edge<stored_weight>;
+
+    static constexpr VertexHandle NONE = UINT32_MAX;    /**< Handle of no vertex, used by `compact()`. */
+
     /**
-     *  Default constructor. 
+     *  Default constructor.
      *
      *  It initializes the graph with an empty collection of vertices and edges.
      */
-    UndirectedGraphWeight() = default;
-    
+    BasicUndirectedGraphWeight() = default;
+
+    /**
+     *  Converts a stored weight (an entry of `neighbor_weights()` or
+     *  `edge_list()`) to `Weight`.
+     */
+    static Weight decode(stored_weight weight)
+    {
+        return Storage::template decode<Weight>(weight);
+    }
+
     /**
      *  Clears the graph.
      */
     void clear()
     {
         vertices_.clear();
+        alive_.clear();
+        removed_ = 0;
         edges_.clear();
-        mapping_.clear();
+        idIndex_.clear();
+        titleIndex_.clear();
+        edgeIndex_.clear();
+        rebuild_adjacency();
     }
 
     /**
      *  Returns the vector with the vertices of the graph.
-     * 
+     *
+     *  Removed vertices stay in the vector until `compact()`; use
+     *  `is_alive()` to skip them.
+     *
      *  @return A const reference to the vector with vertices of the graph.
      */
-    const std::vector<Anime>& vertices() const 
-    { 
-        return vertices_; 
+    const std::vector<Vertex>& vertices() const
+    {
+        return vertices_;
+    }
+
+    /**
+     *  Checks if the vertex at the specified index has not been removed.
+     *
+     *  @param[in]  index   The index of the vertex in `vertices()`.
+     *
+     *  @return True if the vertex is in the graph, false if it is a tombstone.
+     */
+    bool is_alive(size_t index) const
+    {
+        return alive_[index];
+    }
+
+    /**
+     *  Returns the number of vertices in the graph, not counting tombstones.
+     */
+    size_t vertex_count() const
+    {
+        return vertices_.size() - removed_;
     }
 
     /**
-     *  Returns the vector with the edges of the graph.
+     *  Returns the edges of the graph.
+     *
+     *  @return A view over the edges, with their vertices resolved.
+     */
+    EdgeView<Vertex, Weight, Storage> edges() const
+    {
+        return { edges_, vertices_ };
+    }
+
+    /**
+     *  Returns the vector with the edges of the graph, as vertex indices.
      *
      *  @return A const reference to the vector with edges of the graph.
      */
-    const std::vector<edge>& edges() const
+    const std::vector<edge_type>& edge_list() const
     {
         return edges_;
     }
-    
+
     /**
      *  Returns weight of two vertices.
      *
      *  @return A const weight of two vertices.
      */
-    const long double weight(const Anime &v1, const Anime &v2) {
-    // Check if the vertices exist
-        for (const auto &ei : edges_) {
-            if ((ei.v1 == v1 && ei.v2 == v2) || (ei.v1 == v2 && ei.v2 == v1)) {
-                return ei.weight;
-            }
-        }
-        return -1;
+    Weight weight(const Vertex &v1, const Vertex &v2) const {
+        uint32_t position = find_edge(v1, v2);
+        return position == EdgeIndex::NONE ? Weight(-1) : decode(edges_[position].weight);
     }
 
     /**
@@ -87,71 +326,150 @@ public:
      */
     bool empty() const
     {
-        return vertices_.empty();
+        return vertex_count() == 0;
     }
 
     /**
      *  Adds a new vertex to the graph.
      *
+     *  The vertex gets a new index at the end of `vertices()`, also when it
+     *  was removed before.
+     *
      *  @param[in]  v   The identifier of the vertex.
+     *
+     *  @return True if the vertex was added, false if its id is taken.
      */
-    void add_vertex(const Anime& v)
+    bool add_vertex(const Vertex& v)
     {
         // Check if the vertex already exists
         if (contains_vertex(v)) {
             std::cout << "Vertex with the same id already exists" << std::endl;
-            return;
-        }        
-        
+            return false;
+        }
+
         // Add the vertex to the collection of vertices.
         vertices_.push_back({ v });
-
-        // Add the vertex to the mapping.
-        mapping_[v] = vertices_.size() - 1;
+        alive_.push_back(true);
+
+        // Add the vertex to the indexes, with an empty row.
+        index_vertex(static_cast<uint32_t>(vertices_.size() - 1));
+        rowStart_.push_back(static_cast<uint32_t>(adjacency_.size()));
+        rowSize_.push_back(0);
+        rowCapacity_.push_back(0);
+        return true;
     }
 
     /**
-     *  Removes the specified vertex from the graph.
+     *  Removes the specified vertex from the graph in O(degree).
      *
      *  @param[in]  v   The identifier of the vertex to remove.
-     * 
-     *  @note This function uses the erase-remove idiom to remove the vertex from the collection of vertices.
+     *
+     *  @note The vertex stays in `vertices()` as a tombstone until `compact()`;
+     *        the indices of the other vertices do not change.
      */
-    void remove_vertex(const Anime& v)
+    void remove_vertex(const Vertex& v)
     {
         // Check if the vertex exists
-        if (mapping_.find(v) == mapping_.end()) {
+        uint32_t index = idIndex_.find(Traits::id(v));
+        if (index == VertexIdIndex::NONE) {
             std::cout << "Vertex with the id does not exist" << std::endl;
             return;
         }
 
-        // Remove the vertex from the mapping.
-        mapping_.erase(v);
+        // Remove the edges that contain the vertex and release its row.
+        unlink_vertex(index);
+        adjacencyGarbage_ += rowCapacity_[index];
+        rowCapacity_[index] = 0;
 
-        // Remove the vertex from the collection of vertices.                
-        auto new_vertices_end = std::remove(vertices_.begin(), vertices_.end(), v);
-        vertices_.erase(new_vertices_end, vertices_.end());
+        // Remove the vertex from the indexes and leave a tombstone.
+        unindex_vertex(index);
+        alive_[index] = false;
+        ++removed_;
+    }
 
-        // Remove the edges that contain the vertex.
-        auto new_edges_end = std::remove_if(edges_.begin(), edges_.end(),
-            [&v](const edge& edge) {
-                return edge.v1 == v || edge.v2 == v;
-            });
+    /**
+     *  Replaces the data of a vertex, keeping its position in `vertices()`.
+     *
+     *  The edges of the vertex are removed, since they were computed from
+     *  the old data.
+     *
+     *  @param[in]  v           The identifier of the vertex to replace.
+     *  @param[in]  replacement The new data of the vertex.
+     *
+     *  @return True if the vertex was replaced, false if it is not in the
+     *          graph or the new id belongs to another vertex.
+     */
+    bool replace_vertex(const Vertex& v, const Vertex& replacement)
+    {
+        // Check if the vertex exists
+        uint32_t index = idIndex_.find(Traits::id(v));
+        if (index == VertexIdIndex::NONE) {
+            std::cout << "Vertex with the id does not exist" << std::endl;
+            return false;
+        }
+
+        // Check if the new identifier is taken by another vertex
+        uint32_t other = idIndex_.find(Traits::id(replacement));
+        if (other != VertexIdIndex::NONE && other != index) {
+            std::cout << "Vertex with the same id already exists" << std::endl;
+            return false;
+        }
 
-        edges_.erase(new_edges_end, edges_.end());
+        // Remove the edges that contain the vertex.
+        unlink_vertex(index);
 
+        // Replace the vertex and its index entries.
+        unindex_vertex(index);
+        vertices_[index] = replacement;
+        index_vertex(index);
+        return true;
     }
 
     /**
      *  Checks if the graph contains the specified vertex.
      *
      *  @param[in]  v   The identifier of the vertex to check.
-     * 
+     *
      *  @return True if the graph contains the vertex, false otherwise.
      */
-    bool contains_vertex(const Anime& v) const
+    bool contains_vertex(const Vertex& v) const
     {
-        return mapping_.find(v) != mapping_.end();
+        return idIndex_.find(Traits::id(v)) != VertexIdIndex::NONE;
+    }
+
+    /**
+     *  Looks up a vertex by title without throwing.
+     *
+     *  @param[in]  title   The title of the anime.
+     *
+     *  @return The position in `vertices()` of the first vertex with that
+     *          title, or an empty optional if no vertex has it.
+     */
+    std::optional<VertexHandle> find(std::string_view title) const
+    {
+        auto range = titleIndex_.equal_range(title);
+        if (range.first == range.second)
+            return std::nullopt;
+        uint32_t first = range.first->second;
+        for (auto it = range.first; it != range.second; ++it)
+            first = std::min(first, it->second);
+        return first;
+    }
+
+    /**
+     *  Looks up a vertex by `anime_id` without throwing.
+     *
+     *  @param[in]  id  The id of the anime.
+     *
+     *  @return The position of the vertex in `vertices()`, or an empty
+     *          optional if no vertex has that id.
+     */
+    std::optional<VertexHandle> find_by_id(int id) const
+    {
+        uint32_t index = idIndex_.find(id);
+        if (index == VertexIdIndex::NONE)
+            return std::nullopt;
+        return index;
     }
 
     /**
@@ -160,7 +478,7 @@ public:
      *  @param[in]  v1  The identifier of the first vertex of the edge.
      *  @param[in]  v2  The identifier of the second vertex of the edge.
      */
-    void add_edge(const Anime& v1, const Anime& v2, const long double weight)
+    void add_edge(const Vertex& v1, const Vertex& v2, const Weight weight)
     {
         // Check if the vertices exist
         if (!contains_vertex(v1) || !contains_vertex(v2)) {
@@ -169,7 +487,7 @@ public:
         }
 
         // Check if the edge is a loop
-        if (v1 == v2) {
+        if (Traits::id(v1) == Traits::id(v2)) {
             std::cout << "The edge is a loop" << std::endl;
             return;
         }
@@ -180,8 +498,61 @@ public:
             return;
         }
 
-        // Add the edge to the collection of edges.
-        edges_.push_back({ v1, v2, weight });
+        // Add the edge to the collection of edges and to both rows.
+        uint32_t a = idIndex_.find(Traits::id(v1));
+        uint32_t b = idIndex_.find(Traits::id(v2));
+        edgeIndex_.insert(EdgeIndex::key(a, b), static_cast<uint32_t>(edges_.size()));
+        edges_.push_back({ a, b, Storage::encode(weight) });
+        link(edges_.back());
+    }
+
+    /**
+     *  Adds a batch of edges given as vertex indices.
+     *
+     *  Unlike `add_edge`, the edges are not checked one at a time: the batch
+     *  is sorted by vertex pair once, then loops, pairs with an unknown or
+     *  removed vertex, repeated pairs and pairs already in the graph are
+     *  dropped in a single pass. The first occurrence of a repeated pair is
+     *  kept. Large batches rebuild the CSR at the end; small ones are linked
+     *  into the rows of their vertices.
+     *
+     *  @param[in]  batch   The edges to add; `v1` and `v2` are indices in `vertices()`.
+     *
+     *  @return The number of edges added.
+     */
+    size_t add_edges(std::vector<edge_type> batch)
+    {
+        const size_t n = vertices_.size();
+        auto less = [](const edge_type& x, const edge_type& y) { return edge_key(x) < edge_key(y); };
+
+        // Generators such as buildGraph already emit the pairs in order.
+        if (!std::is_sorted(batch.begin(), batch.end(), less))
+            std::stable_sort(batch.begin(), batch.end(), less);
+
+        edges_.reserve(edges_.size() + batch.size());
+        edgeIndex_.reserve(edges_.size() + batch.size());
+        const size_t before = edges_.size();
+        uint64_t previous = UINT64_MAX;
+
+        for (const edge_type& e : batch) {
+            uint64_t key = edge_key(e);
+            if (e.v1 == e.v2 || e.v1 >= n || e.v2 >= n || key == previous)
+                continue;
+            previous = key;
+            if (!alive_[e.v1] || !alive_[e.v2] || edgeIndex_.find(key) != EdgeIndex::NONE)
+                continue;
+            edgeIndex_.insert(key, static_cast<uint32_t>(edges_.size()));
+            edges_.push_back(e);
+        }
+
+        const size_t added = edges_.size() - before;
+        if (added * 4 >= edges_.size()) {
+            rebuild_adjacency();
+        } else {
+            for (size_t e = before; e < edges_.size(); ++e)
+                link(edges_[e]);
+        }
+        return added;
     }
 
     /**
@@ -189,22 +560,28 @@ public:
      *
      *  @param[in]  v1  The identifier of the first vertex of the edge.
      *  @param[in]  v2  The identifier of the second vertex of the edge.
+     *
+     *  @note The last edge of `edges()` takes the place of the removed one.
      */
-    void remove_edge(const Anime& v1, const Anime& v2)
+    void remove_edge(const Vertex& v1, const Vertex& v2)
     {
         // Check if the edge exists
-        if (!contains_edge(v1, v2)) {
+        uint32_t position = find_edge(v1, v2);
+        if (position == EdgeIndex::NONE) {
             std::cout << "The edge does not exist" << std::endl;
             return;
         }
 
-        // Remove the edge from the collection of edges.
-        auto new_edges_end = std::remove_if(edges_.begin(), edges_.end(),
-            [&v1, &v2](const edge& edge) {
-                return (edge.v1 == v1 && edge.v2 == v2) || (edge.v1 == v2 && edge.v2 == v1);
-            });
-
-        edges_.erase(new_edges_end, edges_.end());
+        // Remove the edge from both rows and from the collection of edges.
+        const edge_type& e = edges_[position];
+        uint32_t end = rowStart_[e.v1] + rowSize_[e.v1];
+        for (uint32_t p = rowStart_[e.v1]; p < end; ++p) {
+            if (adjacency_[p] == e.v2) {
+                unlink(e.v1, p);
+                break;
+            }
+        }
+        erase_edge(position);
     }
 
     /**
@@ -215,35 +592,130 @@ public:
      *
      *  @return True if the graph contains the edge, false otherwise.
      */
-    bool contains_edge(const Anime& v1, const Anime& v2) const
+    bool contains_edge(const Vertex& v1, const Vertex& v2) const
+    {
+        return find_edge(v1, v2) != EdgeIndex::NONE;
+    }
+
+    /**
+     *  Rebuilds the CSR without gaps, each row in edge order.
+     *
+     *  `compact()` calls it; on its own it only reclaims the space left by
+     *  moved rows.
+     */
+    void build_adjacency()
     {
-        for (const auto& ei : edges_) {
-            if ((ei.v1 == v1 && ei.v2 == v2) || (ei.v1 == v2 && ei.v2 == v1))
-                return true;
+        rebuild_adjacency();
+    }
+
+    /**
+     *  Checks if enough tombstones or unused adjacency space piled up for
+     *  `compact()` to be worth its O(V + E) cost: a quarter of the vertices
+     *  removed or half of the adjacency arrays unused.
+     */
+    bool needs_compaction() const
+    {
+        return (removed_ > 0 && removed_ * 4 >= vertices_.size())
+            || (adjacencyGarbage_ > 1024 && adjacencyGarbage_ * 2 >= adjacency_.size());
+    }
+
+    /**
+     *  Drops the tombstones and rebuilds the indexes and the CSR without
+     *  gaps. The remaining vertices keep their relative order.
+     *
+     *  @return The new index of each old index of `vertices()`, `NONE` for
+     *          the removed vertices. Handles held by the caller must be
+     *          translated with it.
+     */
+    std::vector<VertexHandle> compact()
+    {
+        std::vector<VertexHandle> remap(vertices_.size(), NONE);
+        uint32_t next = 0;
+        for (uint32_t i = 0; i < vertices_.size(); ++i) {
+            if (!alive_[i])
+                continue;
+            if (next != i)
+                vertices_[next] = std::move(vertices_[i]);
+            remap[i] = next++;
+        }
+        vertices_.resize(next);
+        alive_.assign(next, true);
+        removed_ = 0;
+
+        // Only edges between live vertices are left.
+        for (edge_type& e : edges_) {
+            e.v1 = remap[e.v1];
+            e.v2 = remap[e.v2];
         }
 
-        return false;
+        idIndex_.clear();
+        titleIndex_.clear();
+        for (uint32_t i = 0; i < next; ++i)
+            index_vertex(i);
+        rebuild_edge_index();
+        rebuild_adjacency();
+        return remap;
     }
 
     /**
-     *  Returns the neighbors of the specified vertex.
+     *  Returns the index of the specified vertex in `vertices()`.
      *
      *  @param[in]  v   The identifier of the vertex.
      *
-     *  @return A vector with the identifiers of the neighbors of the vertex.
+     *  @return The index of the vertex.
      */
-    std::vector<Anime> neighbors(const Anime& v) const
-    {   
-        std::vector<Anime> result;
+    size_t index_of(const Vertex& v) const
+    {
+        uint32_t index = idIndex_.find(Traits::id(v));
+        if (index == VertexIdIndex::NONE)
+            throw std::out_of_range("Vertex not in graph");
+        return index;
+    }
 
-        for (const auto& e : edges_) {
-            if (e.v1 == v)
-                result.push_back(vertices_[mapping_.at(e.v2)]);
-            else if (e.v2 == v)
-                result.push_back(vertices_[mapping_.at(e.v1)]);
-        }
+    /**
+     *  Returns the neighbors of the vertex at the specified index.
+     *
+     *  @param[in]  index   The index of the vertex in `vertices()`.
+     *
+     *  @return A view over the indices of the neighbors of the vertex, valid
+     *          until the graph is modified.
+     */
+    Span<uint32_t> neighbors(size_t index) const
+    {
+        const uint32_t* row = adjacency_.data() + rowStart_[index];
+        return { row, row + rowSize_[index] };
+    }
 
-        return result;
+    /**
+     *  Returns the neighbors of the specified vertex.
+     *
+     *  @param[in]  v   The identifier of the vertex.
+     *
+     *  @return A view over the indices of the neighbors of the vertex, valid
+     *          until the graph is modified. It is empty if the vertex is not
+     *          in the graph.
+     */
+    Span<uint32_t> neighbors(const Vertex& v) const
+    {
+        uint32_t index = idIndex_.find(Traits::id(v));
+        if (index == VertexIdIndex::NONE)
+            return {};
+        return neighbors(index);
+    }
+
+    /**
+     *  Returns the weights of the edges of the vertex at the specified index,
+     *  in the same order as `neighbors(index)`. They are in stored form; see
+     *  `decode`.
+     *
+     *  @param[in]  index   The index of the vertex in `vertices()`.
+     *
+     *  @return A view over the weights, valid until the graph is modified.
+     */
+    Span<stored_weight> neighbor_weights(size_t index) const
+    {
+        const stored_weight* row = adjacencyWeights_.data() + rowStart_[index];
+        return { row, row + rowSize_[index] };
     }
 
     /**
@@ -251,9 +723,9 @@ public:
      *
      *  @param[in]  v   The identifier of the vertex.
      *
-     *  @return The degree of the vertex.
+     *  @return The degree of the vertex, or 0 if it is not in the graph.
      */
-    unsigned long long degree(const Anime& v) const
+    unsigned long long degree(const Vertex& v) const
     {
         return neighbors(v).size();
     }
@@ -266,55 +738,26 @@ public:
      *
      *  @return A vector with the identifiers of the vertices in BFS order.
      */
-    std::vector<Anime> bfs(const Anime& start) const
+    std::vector<Vertex> bfs(const Vertex& start) const
     {
         // Check if the graph is empty
         if (vertices_.empty()) {
             std::cout << "Graph is empty" << std::endl;
-            return std::vector<Anime>();
+            return std::vector<Vertex>();
         }
 
         // Check if the vertex exists
         if (!contains_vertex(start)) {
             std::cout << "Vertex with the id does not exists" << std::endl;
-            return std::vector<Anime>();
+            return std::vector<Vertex>();
         }
 
         // Print the BFS traversal message
-        std::cout << "BFS traversal from " << start.name << ": ";
-
-        // Initialize the explored array and the frontier queue
-        std::vector<bool> explored(vertices_.size(), false);
-        std::queue<Anime> frontier;
-        std::vector<Anime> visited;
-
-        // Add the first vertex to the frontier
-        frontier.push(start);
-        explored[mapping_.at(start)] = true;
-
-        // Perform the BFS traversal
-        while (!frontier.empty()) {
-
-            auto current = frontier.front();
-            frontier.pop();
-            size_t currentIndex = mapping_.at(current);
-            visited.push_back(vertices_[currentIndex]);
-
-            for (const auto& neighbor : neighbors(current)) {
+        std::cout << "BFS traversal from " << Traits::title(start) << ": ";
 
-                auto it = mapping_.find(neighbor);
-                if (it != mapping_.end()) {
-
-                    size_t neighborIndex = it->second;
-
-                    if (!explored[neighborIndex]) {
-                        frontier.push(neighbor);
-                        explored[neighborIndex] = true;
-                    }
-
-                }
-            }
-        }
+        std::vector<Vertex> visited;
+        for (uint32_t index : bfs_order(index_of(start)))
+            visited.push_back(vertices_[index]);
 
         return visited;
     }
@@ -327,68 +770,38 @@ public:
      *
      *  @return A vector with the identifiers of the vertices in BFS order.
      */
-    std::vector<Anime> dfs(const Anime& start) const
+    std::vector<Vertex> dfs(const Vertex& start) const
     {
         // Check if the graph is empty
         if (vertices_.empty()) {
             std::cout << "Graph is empty" << std::endl;
-            return std::vector<Anime>();
+            return std::vector<Vertex>();
         }
 
         // Check if the vertex exists
         if (!contains_vertex(start)) {
             std::cout << "Vertex with the id does not exists" << std::endl;
-            return std::vector<Anime>();
+            return std::vector<Vertex>();
         }
 
         // Print the DFS traversal message
-        std::cout << "DFS traversal from " << start.name << ": ";
+        std::cout << "DFS traversal from " << Traits::title(start) << ": ";
 
-        // Initialize the explored array and the frontier stack
-        std::vector<bool> explored(vertices_.size(), false);
-        std::stack<Anime> frontier;
-        std::vector<Anime> visited;
-
-        // Add the first vertex to the frontier
-        frontier.push(start);
-        explored[mapping_.at(start)] = true;
-
-        // Perform the DFS traversal
-        while (!frontier.empty()) {
-
-            Anime current = frontier.top();
-            frontier.pop();
-            size_t currentIndex = mapping_.at(current);
-            visited.push_back(vertices_[currentIndex]);
-
-            for (const auto& neighborId : neighbors(current)) {
-
-                auto it = mapping_.find(neighborId);
-
-                if (it != mapping_.end()) {
-
-                    size_t neighborIndex = it->second;
-
-                    if (!explored[neighborIndex]) {
-                        frontier.push(neighborId);
-                        explored[neighborIndex] = true;
-                    }
-
-                }
-            }
-        }
+        std::vector<Vertex> visited;
+        for (uint32_t index : dfs_order(index_of(start)))
+            visited.push_back(vertices_[index]);
 
         return visited;
     }
 
     /**
-     *  Prints the vertices of the graph starting from the specified vertex 
+     *  Prints the vertices of the graph starting from the specified vertex
      *  using a breadth-first search (BFS) traversal.
-     *  
+     *
      *  @param[in]  start   The identifier of the vertex to start the traversal.
      */
-    void print_bfs(const Anime& start) const
-    {   
+    void print_bfs(const Vertex& start) const
+    {
         // Check if the graph is empty
         if (vertices_.empty()) {
             std::cout << "Graph is empty" << std::endl;
@@ -399,42 +812,13 @@ public:
         if (!contains_vertex(start)) {
             std::cout << "Vertex with the id does not exists" << std::endl;
             return;
-        }        
+        }
 
         // Print the BFS traversal message
-        std::cout << "BFS traversal from " << start.name << ": ";
+        std::cout << "BFS traversal from " << Traits::title(start) << ": ";
 
-        // Initialize the explored array and the frontier queue
-        std::vector<bool> explored(vertices_.size(), false);
-        std::queue<Anime> frontier;
-
-        // Add the first vertex to the frontier
-        frontier.push(start);
-        explored[mapping_.at(start)] = true;
-
-        // Perform the BFS traversal
-        while (!frontier.empty()) {
-
-            auto current = frontier.front();
-            frontier.pop();
-            size_t currentIndex = mapping_.at(current);
-            std::cout << vertices_[currentIndex].name << " ";
-
-            for (const auto& neighbor : neighbors(current)) {
-
-                auto it = mapping_.find(neighbor);
-                if (it != mapping_.end()) {
-                    
-                    size_t neighborIndex = it->second;
-
-                    if (!explored[neighborIndex]) {
-                        frontier.push(neighbor);
-                        explored[neighborIndex] = true;
-                    }
-
-                }
-            }
-        }
+        for (uint32_t index : bfs_order(index_of(start)))
+            std::cout << Traits::title(vertices_[index]) << " ";
 
         std::cout << std::endl;
     }
@@ -445,7 +829,7 @@ public:
      *
      *  @param[in]  start   The identifier of the vertex to start the traversal.
      */
-    void print_dfs(const Anime& start) const
+    void print_dfs(const Vertex& start) const
     {
         // Check if the graph is empty
         if (vertices_.empty()) {
@@ -457,216 +841,474 @@ public:
         if (!contains_vertex(start)) {
             std::cout << "Vertex with the id does not exists" << std::endl;
             return;
-        }    
+        }
 
         // Print the DFS traversal message
-        std::cout << "DFS traversal from " << start.name << ": ";
-
-        // Initialize the explored array and the frontier stack
-        std::vector<bool> explored(vertices_.size(), false);
-        std::stack<Anime> frontier;
+        std::cout << "DFS traversal from " << Traits::title(start) << ": ";
 
-        // Add the first vertex to the frontier
-        frontier.push(start);
-        explored[mapping_.at(start)] = true;
+        for (uint32_t index : dfs_order(index_of(start)))
+            std::cout << Traits::title(vertices_[index]) << " ";
 
-        // Perform the DFS traversal
-        while (!frontier.empty()) {
-
-            Anime current = frontier.top();
-            frontier.pop();
-            size_t currentIndex = mapping_.at(current);
-            std::cout << vertices_[currentIndex].name  << " ";
-
-            for (const auto& neighborId : neighbors(current)) {
-
-                auto it = mapping_.find(neighborId);
-                
-                if (it != mapping_.end()) {
-
-                    size_t neighborIndex = it->second;
+        std::cout << std::endl;
+    }
 
-                    if (!explored[neighborIndex]) {
-                        frontier.push(neighborId);
-                        explored[neighborIndex] = true;
-                    }
+    /**
+     *  Finds a path between two vertices using a breadth-first search (BFS) traversal.
+     *
+     *  @param[in]  start   The identifier of the start vertex.
+     *  @param[in]  end     The identifier of the end vertex.
+     *
+     *  @return A vector with the identifiers of the vertices in the path.
+     */
+    std::vector<Vertex> find_path_bfs(const Vertex& start, const Vertex& end) const
+    {
+        // Check if the graph is empty
+        if (vertices_.empty()) {
+            std::cout << "Graph is empty" << std::endl;
+            return std::vector<Vertex>();
+        }
 
-                }
-            }
+        // Check if the vertices exist
+        if (!contains_vertex(start) || !contains_vertex(end)) {
+            std::cout << "One or more vertices do not exist" << std::endl;
+            return std::vector<Vertex>();
         }
 
-        std::cout << std::endl;
+        return find_path<std::queue<uint32_t>>(index_of(start), index_of(end));
     }
 
     /**
-     *  Finds a path between two vertices using a breadth-first search (BFS) traversal.
+     *  Finds a path between two vertices using a depth-first search (DFS) traversal.
      *
      *  @param[in]  start   The identifier of the start vertex.
      *  @param[in]  end     The identifier of the end vertex.
      *
      *  @return A vector with the identifiers of the vertices in the path.
      */
-    std::vector<Anime> find_path_bfs(const Anime& start, const Anime& end) const
-    {        
-        std::vector<Anime> path;
-
+    std::vector<Vertex> find_path_dfs(const Vertex& start, const Vertex& end) const
+    {
         // Check if the graph is empty
         if (vertices_.empty()) {
             std::cout << "Graph is empty" << std::endl;
-            return path;
+            return std::vector<Vertex>();
         }
 
         // Check if the vertices exist
         if (!contains_vertex(start) || !contains_vertex(end)) {
             std::cout << "One or more vertices do not exist" << std::endl;
-            return path;
+            return std::vector<Vertex>();
         }
 
-        // Initialize the explored array, the parents array, and the frontier queue        
-        std::vector<bool> explored(vertices_.size(), false);
-        std::unordered_map<Anime, Anime, Anime::Hash> parents;
-        std::queue<Anime> frontier;
+        return find_path<std::stack<uint32_t>>(index_of(start), index_of(end));
+    }
 
-        // Add the start vertex to the frontier
-        frontier.push(start);
-        explored[mapping_.at(start)] = true;
-        parents[start] = Anime();
+    /**
+     *  Returns the vertex with the specified title.
+     *
+     *  @param[in]  title   The title of the anime.
+     *
+     *  @return A reference to the vertex.
+     *
+     *  @throws std::runtime_error if no vertex has that title; use `find` to
+     *          look up titles that may be missing.
+     */
+    Vertex& find_vertex(std::string_view title) {
+        std::optional<VertexHandle> index = find(title);
+        if (!index)
+            throw std::runtime_error("Anime not found");
+        return vertices_[*index];
+    }
 
-        // Perform the BFS traversal
-        while (!frontier.empty()) {
+private:
 
-            Anime current = frontier.front();
-            frontier.pop();
+    using Traits = VertexTraits<Vertex>;
 
-            if (current == end) {
-                //  The end vertex has been reached, reconstruct the path
-                Anime pathVertex = current;
-                
-                while (pathVertex.name != "") {
-                    path.push_back(pathVertex);
-                    pathVertex = parents[pathVertex];
-                }
+    std::vector<Vertex> vertices_;                            /**< The vertices of the graph. */
+    std::vector<bool> alive_;                                 /**< False for the removed vertices (tombstones). */
+    size_t removed_ = 0;                                      /**< Number of tombstones in `vertices_`. */
 
-                std::reverse(path.begin(), path.end());
+    std::vector<edge_type> edges_;                                  /**< The edges of the graph. */
+    VertexIdIndex idIndex_;                                          /**< Index in `vertices_` of each id. */
+    std::unordered_multimap<std::string_view, uint32_t> titleIndex_; /**< Indices in `vertices_` of each non-empty title (views into the string arena). */
+
+    EdgeIndex edgeIndex_;                                /**< Position in `edges_` of each edge, keyed on its vertex indices. */
+
+    std::vector<uint32_t> rowStart_;                     /**< Position of the row of each vertex in `adjacency_`. */
+    std::vector<uint32_t> rowSize_;                      /**< Number of neighbors of each vertex. */
+    std::vector<uint32_t> rowCapacity_;                  /**< Slots reserved for the row of each vertex. */
+    std::vector<uint32_t> adjacency_;                    /**< Neighbor indices, grouped by vertex. */
+    std::vector<stored_weight> adjacencyWeights_;        /**< Weight of each entry of `adjacency_`. */
+    std::vector<uint32_t> twin_;                         /**< Position of the entry of the same edge in the other row. */
+    size_t adjacencyGarbage_ = 0;                        /**< Slots of `adjacency_` that belong to no row. */
+
+    /**
+     *  Returns the position of the edge between two vertices in `edges_`,
+     *  or `EdgeIndex::NONE` if there is no such edge.
+     */
+    uint32_t find_edge(const Vertex& v1, const Vertex& v2) const
+    {
+        uint32_t a = idIndex_.find(Traits::id(v1)), b = idIndex_.find(Traits::id(v2));
+        if (a == VertexIdIndex::NONE || b == VertexIdIndex::NONE)
+            return EdgeIndex::NONE;
+        return edgeIndex_.find(EdgeIndex::key(a, b));
+    }
+
+    /**
+     *  Points the id and title of `vertices_[index]` to `index`.
+     */
+    void index_vertex(uint32_t index)
+    {
+        idIndex_.insert(Traits::id(vertices_[index]), index);
+        std::string_view title = Traits::title(vertices_[index]);
+        if (!title.empty())
+            titleIndex_.emplace(title, index);
+    }
+
+    /**
+     *  Removes the id and title of `vertices_[index]` from the indexes; the
+     *  other vertices with the same title stay.
+     */
+    void unindex_vertex(uint32_t index)
+    {
+        idIndex_.erase(Traits::id(vertices_[index]));
+        auto range = titleIndex_.equal_range(Traits::title(vertices_[index]));
+        for (auto it = range.first; it != range.second; ++it) {
+            if (it->second == index) {
+                titleIndex_.erase(it);
                 break;
             }
+        }
+    }
 
-            // Explore the neighbors of the current vertex
-            for (const auto& neighbor : neighbors(current)) {
-
-                auto it = mapping_.find(neighbor);
+    /**
+     *  Returns the key of an edge in `edgeIndex_`.
+     */
+    static uint64_t edge_key(const edge_type& e)
+    {
+        return EdgeIndex::key(e.v1, e.v2);
+    }
 
-                if (it != mapping_.end()) {
+    /**
+     *  Indexes `edges_` again after vertices were renumbered.
+     */
+    void rebuild_edge_index()
+    {
+        edgeIndex_.clear();
+        edgeIndex_.reserve(edges_.size());
+        for (size_t e = 0; e < edges_.size(); ++e)
+            edgeIndex_.insert(edge_key(edges_[e]), static_cast<uint32_t>(e));
+    }
 
-                    size_t neighborIndex = it->second; 
-                    
-                    if (!explored[neighborIndex]) {
-                        frontier.push(neighbor);
-                        explored[neighborIndex] = true;
-                        parents[neighbor] = current;
-                    }
+    /**
+     *  Removes the edge at `position` from `edges_` and `edgeIndex_`; the
+     *  last edge takes its place. The rows are not touched.
+     */
+    void erase_edge(uint32_t position)
+    {
+        edgeIndex_.erase(edge_key(edges_[position]));
+        if (position + 1 != edges_.size()) {
+            edges_[position] = edges_.back();
+            edgeIndex_.insert(edge_key(edges_[position]), position);
+        }
+        edges_.pop_back();
+    }
 
+    /**
+     *  Appends an entry to the row of `vertex`. A full row grows in place
+     *  if it is the last one, otherwise it moves to the end of the arrays
+     *  with twice the capacity.
+     *
+     *  @return The position of the new entry.
+     */
+    uint32_t append_entry(uint32_t vertex, uint32_t neighbor, stored_weight weight)
+    {
+        if (rowSize_[vertex] == rowCapacity_[vertex]) {
+            uint32_t from = rowStart_[vertex];
+            uint32_t capacity = std::max<uint32_t>(4, rowCapacity_[vertex] * 2);
+            bool last = from + rowCapacity_[vertex] == adjacency_.size();
+            uint32_t to = last ? from : static_cast<uint32_t>(adjacency_.size());
+
+            adjacency_.resize(to + capacity);
+            adjacencyWeights_.resize(to + capacity);
+            twin_.resize(to + capacity);
+
+            if (!last) {
+                for (uint32_t k = 0; k < rowSize_[vertex]; ++k) {
+                    adjacency_[to + k] = adjacency_[from + k];
+                    adjacencyWeights_[to + k] = adjacencyWeights_[from + k];
+                    twin_[to + k] = twin_[from + k];
+                    twin_[twin_[to + k]] = to + k;
                 }
+                adjacencyGarbage_ += rowCapacity_[vertex];
+                rowStart_[vertex] = to;
             }
+            rowCapacity_[vertex] = capacity;
         }
 
-        return path;
+        uint32_t position = rowStart_[vertex] + rowSize_[vertex]++;
+        adjacency_[position] = neighbor;
+        adjacencyWeights_[position] = weight;
+        return position;
     }
 
     /**
-     *  Finds a path between two vertices using a depth-first search (DFS) traversal.
+     *  Adds an edge to the rows of both of its vertices.
+     */
+    void link(const edge_type& e)
+    {
+        uint32_t p = append_entry(e.v1, e.v2, e.weight);
+        uint32_t q = append_entry(e.v2, e.v1, e.weight);
+        twin_[p] = q;
+        twin_[q] = p;
+    }
+
+    /**
+     *  Removes the entry at `position` from the row of `vertex`; the last
+     *  entry of the row takes its place.
+     */
+    void remove_entry(uint32_t vertex, uint32_t position)
+    {
+        uint32_t last = rowStart_[vertex] + --rowSize_[vertex];
+        if (position != last) {
+            adjacency_[position] = adjacency_[last];
+            adjacencyWeights_[position] = adjacencyWeights_[last];
+            twin_[position] = twin_[last];
+            twin_[twin_[position]] = position;
+        }
+    }
+
+    /**
+     *  Removes the edge at `position` of the row of `vertex` from both rows
+     *  in O(1).
+     */
+    void unlink(uint32_t vertex, uint32_t position)
+    {
+        uint32_t other = adjacency_[position], twin = twin_[position];
+        remove_entry(vertex, position);
+        remove_entry(other, twin);
+    }
+
+    /**
+     *  Removes every edge of a vertex from the rows, `edges_` and
+     *  `edgeIndex_` in O(degree).
+     */
+    void unlink_vertex(uint32_t index)
+    {
+        while (rowSize_[index] > 0) {
+            uint32_t position = rowStart_[index] + rowSize_[index] - 1;
+            erase_edge(edgeIndex_.find(EdgeIndex::key(index, adjacency_[position])));
+            unlink(index, position);
+        }
+    }
+
+    /**
+     *  Builds the CSR from `edges_` with a counting sort on the vertex index.
+     *  Stable, so each row lists its neighbors in edge order. Rows get no
+     *  spare capacity and no space is left unused.
+     */
+    void rebuild_adjacency()
+    {
+        const size_t n = vertices_.size();
+        rowStart_.assign(n, 0);
+        rowSize_.assign(n, 0);
+
+        for (const edge_type& e : edges_) {
+            ++rowSize_[e.v1];
+            ++rowSize_[e.v2];
+        }
+        uint32_t total = 0;
+        for (size_t i = 0; i < n; ++i) {
+            rowStart_[i] = total;
+            total += rowSize_[i];
+        }
+        rowCapacity_ = rowSize_;
+
+        adjacency_.resize(total);
+        adjacencyWeights_.resize(total);
+        twin_.resize(total);
+        std::vector<uint32_t> cursor(rowStart_);
+        for (const edge_type& e : edges_) {
+            uint32_t p = cursor[e.v1]++, q = cursor[e.v2]++;
+            adjacency_[p] = e.v2;
+            adjacencyWeights_[p] = e.weight;
+            adjacency_[q] = e.v1;
+            adjacencyWeights_[q] = e.weight;
+            twin_[p] = q;
+            twin_[q] = p;
+        }
+        adjacencyGarbage_ = 0;
+    }
+
+    /**
+     *  Returns the next vertex of a BFS or DFS frontier.
+     */
+    static uint32_t peek(const std::queue<uint32_t>& frontier) { return frontier.front(); }
+    static uint32_t peek(const std::stack<uint32_t>& frontier) { return frontier.top(); }
+
+    /**
+     *  Visits the vertices reachable from `start` in the order given by the
+     *  frontier: a queue gives BFS order and a stack gives DFS order.
      *
-     *  @param[in]  start   The identifier of the start vertex.
-     *  @param[in]  end     The identifier of the end vertex.
+     *  @param[in]  start   The index of the vertex to start the traversal.
      *
-     *  @return A vector with the identifiers of the vertices in the path.
+     *  @return The indices of the vertices in visit order.
      */
-    std::vector<Anime> find_path_dfs(const Anime& start, const Anime& end) const
+    template <typename Frontier>
+    std::vector<uint32_t> traverse(size_t start) const
     {
-        std::vector<Anime> path;
+        // Initialize the explored array and the frontier
+        std::vector<bool> explored(vertices_.size(), false);
+        Frontier frontier;
+        std::vector<uint32_t> visited;
 
-        // Check if the graph is empty
-        if (vertices_.empty()) {
-            std::cout << "Graph is empty" << std::endl;
-            return path;
-        }
+        // Add the first vertex to the frontier
+        frontier.push(static_cast<uint32_t>(start));
+        explored[start] = true;
 
-        // Check if the vertices exist
-        if (!contains_vertex(start) || !contains_vertex(end)) {
-            std::cout << "One or more vertices do not exist" << std::endl;
-            return path;
+        // Perform the traversal
+        while (!frontier.empty()) {
+
+            uint32_t current = peek(frontier);
+            frontier.pop();
+            visited.push_back(current);
+
+            for (uint32_t neighbor : neighbors(current)) {
+                if (!explored[neighbor]) {
+                    frontier.push(neighbor);
+                    explored[neighbor] = true;
+                }
+            }
         }
 
-        // Initialize the explored array, the parents array, and the frontier stack
+        return visited;
+    }
+
+    std::vector<uint32_t> bfs_order(size_t start) const { return traverse<std::queue<uint32_t>>(start); }
+    std::vector<uint32_t> dfs_order(size_t start) const { return traverse<std::stack<uint32_t>>(start); }
+
+    /**
+     *  Finds a path between two vertices, exploring them in the order given
+     *  by the frontier (see `traverse`).
+     *
+     *  @param[in]  start   The index of the start vertex.
+     *  @param[in]  end     The index of the end vertex.
+     *
+     *  @return A vector with the identifiers of the vertices in the path.
+     */
+    template <typename Frontier>
+    std::vector<Vertex> find_path(size_t start, size_t end) const
+    {
+        const uint32_t NONE = UINT32_MAX;
+        std::vector<Vertex> path;
+
+        // Initialize the explored array, the parents array, and the frontier
         std::vector<bool> explored(vertices_.size(), false);
-        std::unordered_map<Anime, Anime, Anime::Hash> parents;
-        std::stack<Anime> frontier;
+        std::vector<uint32_t> parents(vertices_.size(), NONE);
+        Frontier frontier;
 
         // Add the start vertex to the frontier
-        frontier.push(start);
-        explored[mapping_.at(start)] = true;
-        parents[start] = Anime();
+        frontier.push(static_cast<uint32_t>(start));
+        explored[start] = true;
 
-        // Perform the DFS traversal
+        // Perform the traversal
         while (!frontier.empty()) {
 
-            Anime current = frontier.top();
+            uint32_t current = peek(frontier);
             frontier.pop();
 
             if (current == end) {
                 //  The end vertex has been reached, reconstruct the path
-                Anime pathVertex = current;
-
-                while (pathVertex.name != "") {
-                    path.push_back(pathVertex);
-                    pathVertex = parents[pathVertex];
-                }
+                for (uint32_t pathVertex = current; pathVertex != NONE; pathVertex = parents[pathVertex])
+                    path.push_back(vertices_[pathVertex]);
 
                 std::reverse(path.begin(), path.end());
                 break;
             }
 
             // Explore the neighbors of the current vertex
-            for (const auto& neighbor : neighbors(current)) {
-
-                auto it = mapping_.find(neighbor);
-                
-                if (it != mapping_.end()) {
-
-                    size_t neighborIndex = it->second;
-
-                    if (!explored[neighborIndex]) {
-                        frontier.push(neighbor);
-                        explored[neighborIndex] = true;
-                        parents[neighbor] = current;
-                    }
-
+            for (uint32_t neighbor : neighbors(current)) {
+                if (!explored[neighbor]) {
+                    frontier.push(neighbor);
+                    explored[neighbor] = true;
+                    parents[neighbor] = current;
                 }
             }
         }
 
         return path;
     }
-    
-    Anime& find_vertex(const std::string& title) {
-        for (Anime& anime : vertices_) {
-            if (anime.name == title) {
-                return anime;
-            }
-        }
-        throw std::runtime_error("Anime not found");
-    }
+};
 
-private:
+/**
+ *  Similarity graph of animes, with weights computed in `Weight` and kept as
+ *  `Storage` says.
+ */
+template <typename Weight, typename Storage = PlainWeights<Weight>>
+using AnimeGraph = BasicUndirectedGraphWeight<Anime, Weight, Storage>;
 
-    std::vector<Anime> vertices_;                             /**< The vertices of the graph. */
+/**
+ *  The graph used by the program: similarities in `long double`, weights
+ *  stored as `float`.
+ */
+using UndirectedGraphWeight = AnimeGraph<long double, PlainWeights<float>>;
 
-    std::vector<edge> edges_;                                       /**< The edges of the graph. */
-    std::unordered_map<Anime, unsigned long long, Anime::Hash> mapping_;   /**< Mapping from vertex Ids to indices in `vertices_`. */
-};
+/*
+ *  The functions below are instantiated in undirectedGraphWeight.cpp for
+ *  UndirectedGraphWeight and for AnimeGraph<long double>, AnimeGraph<double>,
+ *  AnimeGraph<float> and AnimeGraph<float, QuantizedWeights<uint16_t>>.
+ */
+
+template <typename T = long double>
+T calculateSimilarity(const Anime& a, const Anime& b, const SimilarityWeights& weights = SimilarityWeights()); 
 
-long double calculateSimilarity(const Anime& a, const Anime& b); 
+template <typename Weight, typename Storage>
+void buildGraph(AnimeGraph<Weight, Storage>& graph, typename AnimeGraph<Weight, Storage>::weight_type treshold,
+                const SimilarityWeights& weights = SimilarityWeights());
 
-void buildGraph(UndirectedGraphWeight& graph, long double treshold);
+/**
+ *  Same edges as `buildGraph`, in the same order, with the rows split among
+ *  `threads` threads.
+ */
+template <typename Weight, typename Storage>
+void buildGraphParallel(AnimeGraph<Weight, Storage>& graph, typename AnimeGraph<Weight, Storage>::weight_type threshold,
+                        unsigned threads = std::thread::hardware_concurrency(),
+                        const SimilarityWeights& weights = SimilarityWeights());
+
+/**
+ *  Links every vertex with its `k` most similar animes, and symmetrizes the
+ *  result, instead of using a threshold: between V·k/2 and V·k edges however
+ *  the similarities are spread.
+ */
+template <typename Weight, typename Storage>
+void buildGraphTopK(AnimeGraph<Weight, Storage>& graph, size_t k, unsigned threads = std::thread::hardware_concurrency(),
+                    const SimilarityWeights& weights = SimilarityWeights());
+
+/**
+ *  Approximate graph: only the pairs that are close in a bucket of `LshIndex`
+ *  are scored, so it is subquadratic. Every edge is in the exact graph.
+ *
+ *  @return The number of pairs scored.
+ */
+template <typename Weight, typename Storage>
+size_t buildGraphLsh(AnimeGraph<Weight, Storage>& graph, typename AnimeGraph<Weight, Storage>::weight_type threshold,
+                     const LshParams& params = LshParams(), unsigned threads = std::thread::hardware_concurrency(),
+                     const SimilarityWeights& weights = SimilarityWeights());
+
+/**
+ *  Returns the fraction of the edges of `exact` that are also in
+ *  `approximate`.
+ */
+template <typename Weight, typename Storage>
+double edgeRecall(const AnimeGraph<Weight, Storage>& approximate, const AnimeGraph<Weight, Storage>& exact);
+
+template <typename Weight, typename Storage>
+void extendGraph(AnimeGraph<Weight, Storage>& graph, const std::vector<size_t>& changed,
+                 typename AnimeGraph<Weight, Storage>::weight_type threshold,
+                 const SimilarityWeights& weights = SimilarityWeights());
+
+template <typename Weight, typename Storage>
+CompressedGraph buildCompressedGraph(const AnimeGraph<Weight, Storage>& graph,
+                                     typename AnimeGraph<Weight, Storage>::weight_type threshold, unsigned weightBits = 8,
+                                     const SimilarityWeights& weights = SimilarityWeights());
 
 #endif
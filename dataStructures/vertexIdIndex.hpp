@@ -0,0 +1,126 @@
+#ifndef VERTEX_ID_INDEX_HPP
+#define VERTEX_ID_INDEX_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+/**
+ *  Map from an integer id (e.g. `anime_id`) to a vertex index.
+ *
+ *  Ids in `[0, dense size)` are stored in a flat array indexed by id, so
+ *  the usual small, compact id ranges are looked up without hashing. The
+ *  array only grows while it stays below `max(DENSE_MIN, DENSE_FACTOR *
+ *  size())` slots; ids past that go to a hash map.
+ */
+class VertexIdIndex {
+public:
+
+    static constexpr uint32_t NONE = UINT32_MAX;    /**< Returned by `find` when the id is not indexed. */
+
+    /**
+     *  Removes every entry.
+     */
+    void clear()
+    {
+        dense_.clear();
+        sparse_.clear();
+        size_ = 0;
+    }
+
+    /**
+     *  Returns the number of entries.
+     */
+    size_t size() const
+    {
+        return size_;
+    }
+
+    /**
+     *  Looks up an id.
+     *
+     *  @param[in]  id  The id to look up.
+     *
+     *  @return The vertex index of the id, or `NONE` if it is not indexed.
+     */
+    uint32_t find(int id) const
+    {
+        if (id >= 0 && static_cast<size_t>(id) < dense_.size())
+            return dense_[id];
+        auto it = sparse_.find(id);
+        return it == sparse_.end() ? NONE : it->second;
+    }
+
+    /**
+     *  Adds an id, or changes its vertex index if it is already indexed.
+     *
+     *  @param[in]  id      The id.
+     *  @param[in]  index   The vertex index of the id.
+     */
+    void insert(int id, uint32_t index)
+    {
+        if (find(id) == NONE)
+            ++size_;
+
+        if (id >= 0 && static_cast<size_t>(id) >= dense_.size())
+            grow(static_cast<size_t>(id) + 1);
+
+        if (id >= 0 && static_cast<size_t>(id) < dense_.size())
+            dense_[id] = index;
+        else
+            sparse_[id] = index;
+    }
+
+    /**
+     *  Removes an id. Does nothing if it is not indexed.
+     *
+     *  @param[in]  id  The id to remove.
+     */
+    void erase(int id)
+    {
+        if (find(id) == NONE)
+            return;
+        --size_;
+        if (id >= 0 && static_cast<size_t>(id) < dense_.size())
+            dense_[id] = NONE;
+        else
+            sparse_.erase(id);
+    }
+
+private:
+
+    static constexpr size_t DENSE_MIN = 64 * 1024;  /**< Slots the array may always use. */
+    static constexpr size_t DENSE_FACTOR = 4;       /**< Slots allowed per entry past `DENSE_MIN`. */
+
+    std::vector<uint32_t> dense_;                   /**< Vertex index by id, `NONE` for unused ids. */
+    std::unordered_map<int, uint32_t> sparse_;      /**< Ids outside the array. */
+    size_t size_ = 0;                               /**< Number of entries. */
+
+    /**
+     *  Extends the array to cover `needed` ids if the budget allows it, and
+     *  moves the hash map entries it now covers into it.
+     */
+    void grow(size_t needed)
+    {
+        size_t budget = std::max(DENSE_MIN, DENSE_FACTOR * (size_ + 1));
+        if (needed > budget)
+            return;
+
+        size_t capacity = std::max<size_t>(dense_.size() * 2, 1024);
+        capacity = std::min(std::max(capacity, needed), budget);
+        dense_.resize(capacity, NONE);
+
+        for (auto it = sparse_.begin(); it != sparse_.end();) {
+            if (it->first >= 0 && static_cast<size_t>(it->first) < dense_.size()) {
+                dense_[it->first] = it->second;
+                it = sparse_.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+};
+
+#endif
@@ -5,6 +5,7 @@
 #include <ostream>
 #include <string>
 #include <iostream>
+#include <optional>
 #include <set>
 #include <vector>
 
@@ -12,7 +13,7 @@ enum option {BFS, DFS, EXIT};
 
 void printEdges(UndirectedGraphWeight& graph) {
 	// Impresion de nodos similares 
-	std::set<std::string> names;
+	std::set<std::string_view> names;
 	//std::cout << "######## CREACION DE ARCOS ########" << std::endl;
 	for (const auto& edge : graph.edges()) {
 		/*
@@ -29,8 +30,8 @@ void printEdges(UndirectedGraphWeight& graph) {
 	std::cout << "######## PRUEBA DE ADYACENCIA ########" << std::endl;
 	for (const auto& name : names) {
 		std::cout << "Animes adyacentes a '" << name << "' son: ";
-		for (const auto& adyacent : graph.neighbors(graph.find_vertex(name))) {
-			std::cout << "{"<< adyacent.name << "} "; 
+		for (const auto& adyacent : graph.neighbors(*graph.find(name))) {
+			std::cout << "{"<< graph.vertices()[adyacent].name << "} "; 
 		}
 		std::cout << std::endl;
 	}
@@ -40,11 +41,14 @@ void printEdges(UndirectedGraphWeight& graph) {
 	return;
 }
 
-const Anime& selectStartNode(UndirectedGraphWeight& graph) {
+std::optional<VertexHandle> selectStartNode(UndirectedGraphWeight& graph) {
 	std::string name;
 	std::cout << "Escribe el nombre del anime el cual sera como nodo inicial: ";
 	std::getline(std::cin >> std::ws, name);
-	return graph.find_vertex(name);
+	std::optional<VertexHandle> start = graph.find(name);
+	if (!start)
+		std::cout << "No se encontro el anime '" << name << "'" << std::endl;
+	return start;
 }
 
 void printTrail(UndirectedGraphWeight& graph) {
@@ -56,11 +60,13 @@ void printTrail(UndirectedGraphWeight& graph) {
 		std::cin >> option;
 		switch (option) {
 			case BFS:
-				graph.print_bfs(selectStartNode(graph));
+				if (std::optional<VertexHandle> start = selectStartNode(graph))
+					graph.print_bfs(graph.vertices()[*start]);
 				std::cout << std::endl;
 				break;
 			case DFS:
-				graph.print_dfs(selectStartNode(graph));
+				if (std::optional<VertexHandle> start = selectStartNode(graph))
+					graph.print_dfs(graph.vertices()[*start]);
 				std::cout << std::endl;
 				break;
 			case EXIT:
@@ -90,9 +96,14 @@ void printPath(UndirectedGraphWeight& graph) {
 		std::getline(std::cin >> std::ws, name1);
 		std::cout << "Anime que desea encontrar si tiene relacion: ";
 		std::getline(std::cin >> std::ws, name2);
+		std::optional<VertexHandle> start = graph.find(name1), end = graph.find(name2);
+		if ((option == BFS || option == DFS) && (!start || !end)) {
+			std::cout << "No se encontro alguno de los animes" << std::endl;
+			continue;
+		}
 		switch (option) {
 			case BFS:
-				path = graph.find_path_bfs(graph.find_vertex(name1), graph.find_vertex(name2));
+				path = graph.find_path_bfs(graph.vertices()[*start], graph.vertices()[*end]);
 				std::cout << "Camino BFS: " << std::endl;
 				for (size_t i = 0; i < path.size(); i++) {
 					std::cout << path[i].name << " ";
@@ -103,7 +114,7 @@ void printPath(UndirectedGraphWeight& graph) {
 				std::cout << " --> Ponderacion: " << weight << std::endl;
 				break;
 			case DFS:
-				path = graph.find_path_dfs(graph.find_vertex(name1), graph.find_vertex(name2));
+				path = graph.find_path_dfs(graph.vertices()[*start], graph.vertices()[*end]);
 				std::cout << "Camino DFS:" << std::endl;
 				for (size_t i = 0; i < path.size(); i++) {
 					std::cout << path[i].name << " ";
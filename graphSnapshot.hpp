@@ -0,0 +1,205 @@
+#ifndef GRAPH_SNAPSHOT_HPP
+#define GRAPH_SNAPSHOT_HPP
+
+#include "catalogSnapshot.hpp"
+#include "csvReader.hpp"
+#include "dataStructures/undirectedGraphWeight.hpp"
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ *  Binary snapshot of the edges produced by `buildGraph` (`graph.bin`).
+ *
+ *  Layout: a fixed header followed by the edge list as `edge` records, in
+ *  the order of `edge_list()`. The header stores the key the edges were
+ *  built with: the threshold, the `SimilarityWeights` and a fingerprint of
+ *  the vertices. A snapshot only loads into a graph with the same key, so
+ *  a different threshold, weight or catalog means a rebuild.
+ */
+class GraphSnapshot {
+public:
+
+    static constexpr uint32_t VERSION = 1;    /**< Bumped on every layout change. */
+
+    /**
+     *  Writes the edges of a graph to disk. The file is written under a
+     *  temporary name and renamed, so readers never see a partial snapshot.
+     *
+     *  @param[in]  filename    The snapshot path.
+     *  @param[in]  graph       The graph, after `buildGraph`.
+     *  @param[in]  threshold   The threshold passed to `buildGraph`.
+     *  @param[in]  weights     The weights passed to `buildGraph`.
+     *
+     *  @return True if the snapshot was written.
+     */
+    static bool write(const std::string& filename, const UndirectedGraphWeight& graph,
+                      long double threshold, const SimilarityWeights& weights)
+    {
+        const std::vector<edge>& edges = graph.edge_list();
+
+        std::vector<char> file(sizeof(Header) + edges.size() * sizeof(edge));
+        std::memcpy(file.data() + sizeof(Header), edges.data(), edges.size() * sizeof(edge));
+
+        Header header = keyOf(graph, threshold, weights);
+        header.edgeCount = edges.size();
+        header.fileSize = file.size();
+        header.checksum = CatalogSnapshot::checksum(file.data() + sizeof(Header), file.size() - sizeof(Header));
+        std::memcpy(file.data(), &header, sizeof(Header));
+
+        std::string temporary = filename + ".tmp";
+        {
+            std::ofstream out(temporary, std::ios::binary | std::ios::trunc);
+            if (!out.write(file.data(), file.size())) {
+                std::cerr << "Error al escribir el archivo: " << temporary << std::endl;
+                return false;
+            }
+        }
+        return std::rename(temporary.c_str(), filename.c_str()) == 0;
+    }
+
+    /**
+     *  Maps a snapshot and checks that it was built for this graph with
+     *  these parameters.
+     *
+     *  @param[in]  filename    The snapshot path.
+     *  @param[in]  graph       The graph the edges are meant for.
+     *  @param[in]  threshold   The threshold the edges must have been built with.
+     *  @param[in]  weights     The weights the edges must have been built with.
+     *
+     *  @return True if the snapshot is usable, false if it is missing,
+     *          corrupt, from another version or built with another key.
+     */
+    bool open(const std::string& filename, const UndirectedGraphWeight& graph,
+              long double threshold, const SimilarityWeights& weights)
+    {
+        file_ = std::make_unique<MappedFile>(filename);
+        header_ = nullptr;
+
+        std::string_view data = file_->data();
+        if (!file_->is_open() || data.size() < sizeof(Header))
+            return false;
+
+        const Header* header = reinterpret_cast<const Header*>(data.data());
+        Header key = keyOf(graph, threshold, weights);
+        if (std::memcmp(header->magic, MAGIC, sizeof(header->magic)) != 0 || header->version != VERSION
+            || header->fileSize != data.size()
+            || header->fileSize != sizeof(Header) + header->edgeCount * sizeof(edge))
+            return false;
+
+        if (header->vertexCount != key.vertexCount || header->catalogHash != key.catalogHash
+            || std::memcmp(header->threshold, key.threshold, sizeof(key.threshold)) != 0
+            || std::memcmp(header->weights, key.weights, sizeof(key.weights)) != 0)
+            return false;
+
+        if (header->checksum != CatalogSnapshot::checksum(data.data() + sizeof(Header), data.size() - sizeof(Header)))
+            return false;
+
+        header_ = header;
+        return true;
+    }
+
+    /**
+     *  Returns the number of edges in the snapshot.
+     */
+    size_t size() const
+    {
+        return header_ ? header_->edgeCount : 0;
+    }
+
+    /**
+     *  Adds the edges of the snapshot to the graph it was opened for.
+     *
+     *  @param[out] graph   The graph passed to `open`.
+     */
+    void read(UndirectedGraphWeight& graph) const
+    {
+        const edge* edges = reinterpret_cast<const edge*>(file_->data().data() + sizeof(Header));
+        graph.add_edges(std::vector<edge>(edges, edges + size()));
+    }
+
+    /**
+     *  Hashes the vertices of a graph in order, with every attribute that
+     *  `calculateSimilarity` reads. Tombstones hash as a marker, so edge
+     *  indices stay meaningful.
+     */
+    static uint64_t fingerprint(const UndirectedGraphWeight& graph)
+    {
+        std::string bytes;
+        auto append = [&bytes](const void* data, size_t size) {
+            bytes.append(static_cast<const char*>(data), size);
+        };
+        auto appendString = [&](std::string_view text) {
+            uint32_t length = static_cast<uint32_t>(text.size());
+            append(&length, sizeof(length));
+            append(text.data(), text.size());
+        };
+
+        for (size_t i = 0; i < graph.vertices().size(); ++i) {
+            uint8_t alive = graph.is_alive(i);
+            append(&alive, sizeof(alive));
+            if (!alive)
+                continue;
+
+            const Anime& anime = graph.vertices()[i];
+            append(&anime.anime_id, sizeof(anime.anime_id));
+            appendString(anime.name);
+            uint32_t genres = static_cast<uint32_t>(anime.genres.size());
+            append(&genres, sizeof(genres));
+            for (const auto& genre : anime.genres)
+                appendString(genre);
+            appendString(anime.type);
+            append(&anime.episodes, sizeof(anime.episodes));
+            append(&anime.rating, sizeof(anime.rating));
+            append(&anime.members, sizeof(anime.members));
+        }
+        return CatalogSnapshot::checksum(bytes.data(), bytes.size());
+    }
+
+private:
+
+    static constexpr char MAGIC[8] = {'A', 'N', 'I', 'G', 'R', 'A', 'P', 'H'};
+
+    static_assert(sizeof(edge) == 12, "edge records are stored as they are in memory");
+
+    struct Header {
+        char magic[8];
+        uint32_t version;
+        uint32_t vertexCount;               /**< Size of `vertices()`, tombstones included. */
+        uint64_t edgeCount;
+        double threshold[2];                /**< Threshold as a sum of two doubles, so a long double round trips. */
+        double weights[5];                  /**< `SimilarityWeights`, in declaration order. */
+        uint64_t catalogHash;               /**< `fingerprint` of the vertices. */
+        uint64_t fileSize;
+        uint64_t checksum;                  /**< Checksum of everything after the header. */
+    };
+
+    // Fills in the fields of the header that identify the edges
+    static Header keyOf(const UndirectedGraphWeight& graph, long double threshold, const SimilarityWeights& weights)
+    {
+        Header header{};
+        std::memcpy(header.magic, MAGIC, sizeof(header.magic));
+        header.version = VERSION;
+        header.vertexCount = static_cast<uint32_t>(graph.vertices().size());
+        header.threshold[0] = static_cast<double>(threshold);
+        header.threshold[1] = static_cast<double>(threshold - header.threshold[0]);
+        header.weights[0] = weights.genre;
+        header.weights[1] = weights.type;
+        header.weights[2] = weights.episodes;
+        header.weights[3] = weights.rating;
+        header.weights[4] = weights.members;
+        header.catalogHash = fingerprint(graph);
+        return header;
+    }
+
+    std::unique_ptr<MappedFile> file_;      /**< The mapped snapshot. */
+    const Header* header_{nullptr};         /**< Header of a validated snapshot, null otherwise. */
+};
+
+#endif // GRAPH_SNAPSHOT_HPP
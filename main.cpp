@@ -2,14 +2,29 @@
 #include "dataStructures/undirectedGraphWeight.hpp"
 #include "utilities.hpp"
 #include <iostream>
+#include <string>
 #include <vector>
 #include <chrono>
 #include "dataStructures/trie.hpp"
 
 
-int main() {
+int main(int argc, char* argv[]) {
     int choice = 0;
 
+    // ./main --publicar [umbral]: publica el catálogo y el grafo en memoria compartida y termina
+    if (argc > 1 && std::string(argv[1]) == "--publicar") {
+        long double threshold = argc > 2 ? std::stold(argv[2]) : 0.8;
+        uint64_t generation = publishCatalog("anime.csv", SHARED_CATALOG, threshold);
+        if (generation == 0)
+            return 1;
+        std::cout << "Catálogo publicado en " << SHARED_CATALOG << " (generación " << generation << ")\n";
+        return 0;
+    }
+
+    // Si otro proceso publicó el catálogo, se usa esa copia en vez de cargar la propia
+    if (uint64_t generation = attachSharedCatalog())
+        std::cout << "Usando el catálogo compartido " << SHARED_CATALOG << " (generación " << generation << ")\n";
+
     do {
         std::cout << "\n--- Menú Principal ---\n";
         std::cout << "1. Optimización de búsquedas de productos (Trie)\n";
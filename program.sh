@@ -1,4 +1,16 @@
 #!/bin/bash
 
-g++ -O3 main.cpp dataStructures/undirectedGraphWeight.cpp -o main
-./main
+# ./program.sh test [nombre]: compila y corre las pruebas de tests/ (o solo tests/<nombre>.cpp)
+if [ "$1" == "test" ]; then
+    mkdir -p build
+    for test in tests/${2:-*}.cpp; do
+        name=$(basename "$test" .cpp)
+        g++ -O3 -pthread "$test" dataStructures/undirectedGraphWeight.cpp -o "build/$name" || exit 1
+        "./build/$name" || exit 1
+    done
+    exit 0
+fi
+
+# ./program.sh --publicar [umbral]: publica el catálogo en memoria compartida para otros procesos
+g++ -O3 -pthread main.cpp dataStructures/undirectedGraphWeight.cpp -o main
+./main "$@"
@@ -0,0 +1,414 @@
+#ifndef SHARED_SEGMENT_HPP
+#define SHARED_SEGMENT_HPP
+
+#include "catalog.hpp"
+#include "catalogSnapshot.hpp"
+#include "dataStructures/undirectedGraphWeight.hpp"
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/**
+ *  Read-only catalog and similarity graph shared between processes through
+ *  POSIX shared memory.
+ *
+ *  A publisher lays out the catalog (as a `CatalogSnapshot` image) and a
+ *  gap-free CSR copy of the graph in one segment, `<name>.<generation>`.
+ *  Everything in the segment is addressed by offsets, so readers map it
+ *  read-only at any address and share its physical pages; attaching only
+ *  checks the headers.
+ *
+ *  The control segment `<name>` holds the current generation. Publishing
+ *  writes the whole new segment first, then bumps the generation and
+ *  unlinks the previous segment. Readers that are still attached to an
+ *  older generation keep their mapping, which stays valid until they
+ *  detach; `is_current()` tells them a newer one exists.
+ */
+class SharedSegment {
+public:
+
+    static constexpr uint32_t VERSION = 1;          /**< Bumped on every layout change. */
+    static constexpr uint32_t NONE = UINT32_MAX;    /**< Catalog row of a removed vertex. */
+
+    SharedSegment() = default;
+    SharedSegment(const SharedSegment&) = delete;
+    SharedSegment& operator=(const SharedSegment&) = delete;
+
+    /**
+     *  Destructor. Detaches from the segment.
+     */
+    ~SharedSegment()
+    {
+        detach();
+    }
+
+    /**
+     *  Publishes a catalog and a graph built from it as a new generation.
+     *
+     *  @param[in]  name        The segment name, e.g. "/anime-recommender".
+     *  @param[in]  catalog     The catalog.
+     *  @param[in]  graph       The similarity graph; every vertex must be in
+     *                          the catalog (matched by `anime_id`).
+     *  @param[in]  source      The CSV the catalog was read from.
+     *
+     *  @return The new generation, or 0 on error.
+     */
+    static uint64_t publish(const std::string& name, const Catalog& catalog,
+                            const UndirectedGraphWeight& graph, const std::string& source)
+    {
+        std::vector<char> image = CatalogSnapshot::serialize(catalog, source);
+        if (image.empty())
+            return 0;
+
+        // Catalog row of each vertex
+        std::unordered_map<int, uint32_t> rows;
+        rows.reserve(catalog.animes.size());
+        for (AnimeHandle handle = 0; handle < catalog.animes.size(); ++handle)
+            rows.emplace(catalog.animes.ids()[handle], handle);
+
+        const size_t n = graph.vertices().size();
+        std::vector<uint32_t> vertexRows(n, NONE), rowOffsets{0}, neighbors;
+        std::vector<float> weights;
+        neighbors.reserve(2 * graph.edge_list().size());
+        weights.reserve(2 * graph.edge_list().size());
+        for (size_t i = 0; i < n; ++i) {
+            if (graph.is_alive(i)) {
+                auto it = rows.find(graph.vertices()[i].anime_id);
+                if (it == rows.end()) {
+                    std::cerr << "El anime " << graph.vertices()[i].anime_id << " no esta en el catalogo" << std::endl;
+                    return 0;
+                }
+                vertexRows[i] = it->second;
+                for (uint32_t neighbor : graph.neighbors(i))
+                    neighbors.push_back(neighbor);
+                for (float weight : graph.neighbor_weights(i))
+                    weights.push_back(weight);
+            }
+            rowOffsets.push_back(static_cast<uint32_t>(neighbors.size()));
+        }
+
+        // Lay out the sections after the header
+        Header header{};
+        std::memcpy(header.magic, MAGIC, sizeof(header.magic));
+        header.version = VERSION;
+        header.vertexCount = static_cast<uint32_t>(n);
+        header.entryCount = neighbors.size();
+        header.catalogSize = image.size();
+
+        size_t size = sizeof(Header);
+        auto place = [&size, &header](Section section, size_t bytes) {
+            size = (size + 7) & ~size_t(7);
+            header.sections[section] = size;
+            size += bytes;
+        };
+        place(CATALOG, image.size());
+        place(VERTEX_ROWS, vertexRows.size() * sizeof(uint32_t));
+        place(ROW_OFFSETS, rowOffsets.size() * sizeof(uint32_t));
+        place(NEIGHBORS, neighbors.size() * sizeof(uint32_t));
+        place(WEIGHTS, weights.size() * sizeof(float));
+        header.size = size;
+
+        Control* control = openControl(name, true);
+        if (control == nullptr)
+            return 0;
+        header.generation = control->next.fetch_add(1) + 1;
+
+        // The new segment is complete before its generation becomes visible
+        std::string segment = segmentName(name, header.generation);
+        int fd = ::shm_open(segment.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+        void* address = MAP_FAILED;
+        if (fd >= 0 && ::ftruncate(fd, static_cast<off_t>(size)) == 0)
+            address = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (fd >= 0)
+            ::close(fd);
+        if (address == MAP_FAILED) {
+            std::cerr << "Error al crear el segmento: " << segment << std::endl;
+            ::shm_unlink(segment.c_str());
+            ::munmap(control, sizeof(Control));
+            return 0;
+        }
+
+        char* base = static_cast<char*>(address);
+        std::memcpy(base, &header, sizeof(Header));
+        std::memcpy(base + header.sections[CATALOG], image.data(), image.size());
+        std::memcpy(base + header.sections[VERTEX_ROWS], vertexRows.data(), vertexRows.size() * sizeof(uint32_t));
+        std::memcpy(base + header.sections[ROW_OFFSETS], rowOffsets.data(), rowOffsets.size() * sizeof(uint32_t));
+        std::memcpy(base + header.sections[NEIGHBORS], neighbors.data(), neighbors.size() * sizeof(uint32_t));
+        std::memcpy(base + header.sections[WEIGHTS], weights.data(), weights.size() * sizeof(float));
+        ::munmap(address, size);
+
+        // Only a newer generation replaces the current one
+        uint64_t previous = control->generation.load();
+        while (previous < header.generation
+               && !control->generation.compare_exchange_weak(previous, header.generation)) {
+        }
+        if (previous < header.generation && previous != 0)
+            ::shm_unlink(segmentName(name, previous).c_str());
+        else if (previous > header.generation)
+            ::shm_unlink(segment.c_str());
+
+        ::munmap(control, sizeof(Control));
+        return header.generation;
+    }
+
+    /**
+     *  Unlinks the control segment and the current generation. Attached
+     *  readers are not affected.
+     *
+     *  @param[in]  name    The segment name.
+     */
+    static void remove(const std::string& name)
+    {
+        if (Control* control = openControl(name, false)) {
+            ::shm_unlink(segmentName(name, control->generation.load()).c_str());
+            ::munmap(control, sizeof(Control));
+        }
+        ::shm_unlink(name.c_str());
+    }
+
+    /**
+     *  Maps the current generation read-only. Detaches first if attached.
+     *
+     *  @param[in]  name    The segment name.
+     *
+     *  @return False if nothing was published under this name, or if the
+     *          segment of the current generation has a bad header (wrong
+     *          magic, version, generation or size, or sections out of bounds).
+     */
+    bool attach(const std::string& name)
+    {
+        detach();
+
+        Control* control = openControl(name, false);
+        if (control == nullptr)
+            return false;
+
+        // A publisher may unlink the generation we just read; read it again then
+        uint64_t generation = 0;
+        for (int attempt = 0; attempt < 8 && base_ == nullptr; ++attempt) {
+            generation = control->generation.load();
+            if (generation == 0)
+                break;
+
+            int fd = ::shm_open(segmentName(name, generation).c_str(), O_RDONLY, 0);
+            if (fd < 0) {
+                if (errno == ENOENT)
+                    continue;
+                break;
+            }
+            struct stat info;
+            void* address = MAP_FAILED;
+            if (::fstat(fd, &info) == 0 && static_cast<size_t>(info.st_size) >= sizeof(Header))
+                address = ::mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_SHARED, fd, 0);
+            ::close(fd);
+            if (address == MAP_FAILED)
+                break;
+
+            base_ = static_cast<const char*>(address);
+            size_ = static_cast<size_t>(info.st_size);
+        }
+
+        control_ = control;
+        if (base_ == nullptr || !validate(generation)) {
+            detach();
+            return false;
+        }
+        return true;
+    }
+
+    /**
+     *  Unmaps the segment. Does nothing if not attached.
+     */
+    void detach()
+    {
+        if (base_ != nullptr)
+            ::munmap(const_cast<char*>(base_), size_);
+        if (control_ != nullptr)
+            ::munmap(control_, sizeof(Control));
+        base_ = nullptr;
+        size_ = 0;
+        control_ = nullptr;
+        header_ = nullptr;
+    }
+
+    /**
+     *  Returns true while attached.
+     */
+    bool is_attached() const
+    {
+        return header_ != nullptr;
+    }
+
+    /**
+     *  Returns the generation this reader is attached to.
+     */
+    uint64_t generation() const
+    {
+        return header_ ? header_->generation : 0;
+    }
+
+    /**
+     *  Returns false once a newer generation has been published.
+     */
+    bool is_current() const
+    {
+        return header_ && control_->generation.load() == header_->generation;
+    }
+
+    /**
+     *  Returns the catalog of the segment.
+     */
+    const CatalogSnapshot& catalog() const
+    {
+        return catalog_;
+    }
+
+    /**
+     *  Returns the number of vertices, removed ones included.
+     */
+    size_t vertex_count() const
+    {
+        return header_ ? header_->vertexCount : 0;
+    }
+
+    /**
+     *  Returns the catalog row of a vertex, or `NONE` if it was removed.
+     */
+    uint32_t anime(size_t vertex) const
+    {
+        return column<uint32_t>(VERTEX_ROWS)[vertex];
+    }
+
+    /**
+     *  Returns the neighbors of a vertex, in the order of `neighbors()` of
+     *  the published graph.
+     */
+    Span<uint32_t> neighbors(size_t vertex) const
+    {
+        const uint32_t* offsets = column<uint32_t>(ROW_OFFSETS);
+        const uint32_t* entries = column<uint32_t>(NEIGHBORS);
+        return Span<uint32_t>(entries + offsets[vertex], entries + offsets[vertex + 1]);
+    }
+
+    /**
+     *  Returns the weights of the edges in `neighbors(vertex)`.
+     */
+    Span<float> neighbor_weights(size_t vertex) const
+    {
+        const uint32_t* offsets = column<uint32_t>(ROW_OFFSETS);
+        const float* entries = column<float>(WEIGHTS);
+        return Span<float>(entries + offsets[vertex], entries + offsets[vertex + 1]);
+    }
+
+private:
+
+    static constexpr char MAGIC[8] = {'A', 'N', 'I', 'S', 'H', 'M', '\0', '\0'};
+
+    enum Section { CATALOG, VERTEX_ROWS, ROW_OFFSETS, NEIGHBORS, WEIGHTS, SECTION_COUNT };
+
+    struct Header {
+        char magic[8];
+        uint32_t version;
+        uint32_t vertexCount;
+        uint64_t generation;
+        uint64_t entryCount;                /**< Adjacency entries, two per edge. */
+        uint64_t catalogSize;               /**< Size of the catalog image. */
+        uint64_t size;                      /**< Size of the segment. */
+        uint64_t sections[SECTION_COUNT];   /**< Offset of each section. */
+    };
+
+    struct Control {
+        char magic[8];
+        std::atomic<uint64_t> generation;   /**< Generation readers attach to, 0 before the first publish. */
+        std::atomic<uint64_t> next;         /**< Last generation handed out to a publisher. */
+    };
+
+    static_assert(std::atomic<uint64_t>::is_always_lock_free, "the counters live in shared memory");
+
+    static std::string segmentName(const std::string& name, uint64_t generation)
+    {
+        return name + "." + std::to_string(generation);
+    }
+
+    // Maps the control segment, creating it (writable) if asked to, read-only
+    // otherwise. Zero-filled pages are valid counters, so creators race safely.
+    static Control* openControl(const std::string& name, bool create)
+    {
+        int fd = ::shm_open(name.c_str(), create ? O_CREAT | O_RDWR : O_RDONLY, 0644);
+        if (fd < 0)
+            return nullptr;
+
+        struct stat info;
+        void* address = MAP_FAILED;
+        if (::fstat(fd, &info) == 0
+            && (static_cast<size_t>(info.st_size) >= sizeof(Control)
+                || (create && ::ftruncate(fd, sizeof(Control)) == 0)))
+            address = ::mmap(nullptr, sizeof(Control), create ? PROT_READ | PROT_WRITE : PROT_READ, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if (address == MAP_FAILED)
+            return nullptr;
+
+        Control* control = static_cast<Control*>(address);
+        if (create)
+            std::memcpy(control->magic, MAGIC, sizeof(control->magic));
+        else if (std::memcmp(control->magic, MAGIC, sizeof(control->magic)) != 0) {
+            ::munmap(address, sizeof(Control));
+            return nullptr;
+        }
+        return control;
+    }
+
+    // Checks the header of the segment of a generation and the section bounds; O(1)
+    bool validate(uint64_t generation)
+    {
+        const Header* header = reinterpret_cast<const Header*>(base_);
+        if (std::memcmp(header->magic, MAGIC, sizeof(header->magic)) != 0 || header->version != VERSION
+            || header->generation != generation || header->size != size_)
+            return false;
+
+        const uint64_t* sections = header->sections;
+        size_t ends[SECTION_COUNT] = {
+            sections[VERTEX_ROWS], sections[ROW_OFFSETS], sections[NEIGHBORS], sections[WEIGHTS], size_
+        };
+        for (int s = 0; s < SECTION_COUNT; ++s) {
+            if (sections[s] < sizeof(Header) || sections[s] > ends[s] || ends[s] > size_)
+                return false;
+        }
+        if (ends[VERTEX_ROWS] - sections[VERTEX_ROWS] < header->vertexCount * sizeof(uint32_t)
+            || ends[ROW_OFFSETS] - sections[ROW_OFFSETS] < (header->vertexCount + 1) * sizeof(uint32_t)
+            || ends[NEIGHBORS] - sections[NEIGHBORS] < header->entryCount * sizeof(uint32_t)
+            || ends[WEIGHTS] - sections[WEIGHTS] < header->entryCount * sizeof(float))
+            return false;
+
+        if (ends[CATALOG] - sections[CATALOG] < header->catalogSize
+            || !catalog_.view(std::string_view(base_ + sections[CATALOG], header->catalogSize)))
+            return false;
+
+        header_ = header;
+        return true;
+    }
+
+    template <typename T>
+    const T* column(Section section) const
+    {
+        return reinterpret_cast<const T*>(base_ + header_->sections[section]);
+    }
+
+    const char* base_{nullptr};             /**< The mapped segment. */
+    size_t size_{0};
+    Control* control_{nullptr};             /**< The mapped control segment. */
+    const Header* header_{nullptr};         /**< Header of a validated segment, null otherwise. */
+    CatalogSnapshot catalog_;               /**< View of the catalog section. */
+};
+
+#endif // SHARED_SEGMENT_HPP
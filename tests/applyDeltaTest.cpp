@@ -0,0 +1,291 @@
+// Prueba de applyDelta: parte anime.csv en una base y un delta (filas nuevas y
+// filas modificadas), aplica el delta al grafo, al catálogo, al Trie y al AVL
+// construidos con la base, y compara el resultado con lo que se construye
+// desde cero con el archivo combinado.
+//
+// Uso: applyDeltaTest [anime.csv] [semillas]
+
+#include "../utilities.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <tuple>
+#include <vector>
+
+namespace {
+
+// Generador congruencial: la partición depende solo de la semilla
+struct Random {
+    uint64_t state;
+
+    uint32_t next(uint32_t bound)
+    {
+        state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+        return static_cast<uint32_t>((state >> 33) % bound);
+    }
+};
+
+// Campos de una fila tal como están en el archivo (con comillas), para poder
+// cambiarlos sin alterar el resto de la fila
+std::vector<std::string> splitFields(const std::string& line)
+{
+    std::vector<std::string> fields(1);
+    bool quoted = false;
+    for (char c : line) {
+        if (c == '"')
+            quoted = !quoted;
+        if (c == ',' && !quoted)
+            fields.emplace_back();
+        else
+            fields.back() += c;
+    }
+    return fields;
+}
+
+std::string joinFields(const std::vector<std::string>& fields)
+{
+    std::string line;
+    for (size_t i = 0; i < fields.size(); ++i)
+        line += (i > 0 ? "," : "") + fields[i];
+    return line;
+}
+
+void writeCsv(const std::string& filename, const std::string& header, const std::vector<std::string>& rows)
+{
+    std::ofstream out(filename, std::ios::binary);
+    out << header << "\r\n";
+    for (const std::string& row : rows)
+        out << row << "\r\n";
+}
+
+// Cambia un campo de una fila válida, sin que deje de serlo: miembros (cruza el
+// filtro del grafo), puntaje, géneros (tomados de otra fila válida), título o
+// episodios
+std::string changeRow(const std::string& row, const std::vector<std::string>& validRows, Random& random)
+{
+    std::vector<std::string> fields = splitFields(row);
+    if (fields.size() != 7)
+        return row;
+
+    switch (random.next(5)) {
+        case 0: {
+            static const char* members[] = { "100000", "199999", "200000", "250000", "900000" };
+            fields[6] = members[random.next(5)];
+            break;
+        }
+        case 1:
+            fields[5] = std::to_string(5 + random.next(450) / 100.0).substr(0, 4);
+            break;
+        case 2: {
+            std::vector<std::string> other = splitFields(validRows[random.next(static_cast<uint32_t>(validRows.size()))]);
+            if (other.size() == 7)
+                fields[2] = other[2];
+            break;
+        }
+        case 3:
+            if (!fields[1].empty() && fields[1].front() == '"')
+                fields[1].insert(1, "Re: ");
+            else
+                fields[1] = "Re: " + fields[1];
+            break;
+        default:
+            fields[4] = std::to_string(1 + random.next(100));
+    }
+    return joinFields(fields);
+}
+
+// Aristas del grafo como (id menor, id mayor, peso guardado), ordenadas, para
+// comparar grafos cuyos vértices quedaron en otro orden
+std::vector<std::tuple<int, int, float>> edgeSet(const UndirectedGraphWeight& graph)
+{
+    std::vector<std::tuple<int, int, float>> edges;
+    for (const edge& e : graph.edge_list()) {
+        int a = graph.vertices()[e.v1].anime_id, b = graph.vertices()[e.v2].anime_id;
+        edges.emplace_back(std::min(a, b), std::max(a, b), e.weight);
+    }
+    std::sort(edges.begin(), edges.end());
+    return edges;
+}
+
+std::vector<int> vertexIds(const UndirectedGraphWeight& graph)
+{
+    std::vector<int> ids;
+    for (size_t i = 0; i < graph.vertices().size(); ++i) {
+        if (graph.is_alive(i))
+            ids.push_back(graph.vertices()[i].anime_id);
+    }
+    std::sort(ids.begin(), ids.end());
+    return ids;
+}
+
+bool sameCatalog(const AnimeCatalog& a, const AnimeCatalog& b)
+{
+    if (a.size() != b.size() || a.ids() != b.ids() || a.names() != b.names()
+        || a.genre_masks() != b.genre_masks() || a.episodes() != b.episodes()
+        || a.ratings() != b.ratings() || a.members() != b.members()
+        || a.genre_offsets() != b.genre_offsets() || a.genre_list() != b.genre_list())
+        return false;
+    for (AnimeHandle handle = 0; handle < a.size(); ++handle) {
+        if (a[handle].type() != b[handle].type())
+            return false;
+    }
+    return true;
+}
+
+int failures = 0;
+
+void check(bool condition, const std::string& what, uint64_t seed)
+{
+    if (!condition) {
+        std::cout << "FALLA (semilla " << seed << "): " << what << std::endl;
+        ++failures;
+    }
+}
+
+void runSeed(const std::string& header, const std::vector<std::string>& rows, const std::vector<bool>& valid,
+             const std::vector<std::string>& validRows, uint64_t seed, const std::string& directory)
+{
+    Random random{ seed };
+
+    // Un 3% de las filas pasa al delta como filas nuevas y un 2% de las válidas se modifica
+    // (una fila inválida que se vuelve válida se agregaría al final, no en su lugar)
+    std::vector<std::string> base, added;
+    std::vector<bool> baseValid;
+    for (size_t i = 0; i < rows.size(); ++i) {
+        if (random.next(100) < 3) {
+            added.push_back(rows[i]);
+        } else {
+            base.push_back(rows[i]);
+            baseValid.push_back(valid[i]);
+        }
+    }
+    std::vector<std::string> merged = base, delta;
+    for (size_t i = 0; i < base.size(); ++i) {
+        if (baseValid[i] && random.next(100) < 2) {
+            merged[i] = changeRow(base[i], validRows, random);
+            delta.push_back(merged[i]);
+        }
+    }
+
+    // El delta mezcla filas nuevas y modificadas; las nuevas van al final del combinado en el orden del delta
+    delta.insert(delta.end(), added.begin(), added.end());
+    for (size_t i = delta.size(); i > 1; --i)
+        std::swap(delta[i - 1], delta[random.next(static_cast<uint32_t>(i))]);
+    std::sort(added.begin(), added.end());
+    for (const std::string& row : delta) {
+        if (std::binary_search(added.begin(), added.end(), row))
+            merged.push_back(row);
+    }
+
+    std::string baseFile = directory + "/base.csv", deltaFile = directory + "/delta.csv",
+                mergedFile = directory + "/merged.csv";
+    writeCsv(baseFile, header, base);
+    writeCsv(deltaFile, header, delta);
+    writeCsv(mergedFile, header, merged);
+
+    // Grafo
+    for (long double threshold : { 0.6L, 0.8L }) {
+        UndirectedGraphWeight incremental, full;
+        readCSV(baseFile, incremental);
+        buildGraph(incremental, threshold);
+        applyDelta(deltaFile, incremental, threshold);
+        readCSV(mergedFile, full);
+        buildGraph(full, threshold);
+
+        std::string at = " (umbral " + std::to_string(static_cast<double>(threshold)).substr(0, 3) + ")";
+        check(vertexIds(incremental) == vertexIds(full), "vértices del grafo" + at, seed);
+        check(edgeSet(incremental) == edgeSet(full), "arcos del grafo" + at, seed);
+    }
+
+    // Catálogo, Trie y AVL
+    Catalog incremental, full;
+    buildCatalog(baseFile, incremental);
+    Trie trie;
+    for (AnimeHandle handle = 0; handle < incremental.animes.size(); ++handle)
+        trie.insert(incremental.animes.names()[handle], handle);
+    const GenreDictionary& genres = GenreDictionary::instance();
+    AVLTree<std::string, std::vector<AnimeHandle>> categoryAVL;
+    std::vector<unsigned> baseGenres = incremental.genre_ids();
+    for (unsigned genre : baseGenres)
+        categoryAVL.insert(genres.name(genre), incremental.postings[genre]);
+
+    std::vector<CatalogChange> changes = applyDelta(deltaFile, incremental);
+    applyDelta(changes, incremental, trie);
+    applyDelta(changes, incremental, categoryAVL);
+    buildCatalog(mergedFile, full);
+
+    check(sameCatalog(incremental.animes, full.animes), "catálogo", seed);
+    check(incremental.genre_ids() == full.genre_ids(), "géneros del catálogo", seed);
+    for (unsigned genre : full.genre_ids()) {
+        check(incremental.postings[genre] == full.postings[genre], "animes del género " + std::string(genres.name(genre)), seed);
+        check(categoryAVL[std::string(genres.name(genre))] == full.postings[genre], "AVL del género " + std::string(genres.name(genre)), seed);
+    }
+    for (unsigned genre : baseGenres) {
+        if (full.postings.size() <= genre || full.postings[genre].empty())
+            check(categoryAVL[std::string(genres.name(genre))].empty(), "AVL del género vacío " + std::string(genres.name(genre)), seed);
+    }
+
+    Trie fullTrie;
+    for (AnimeHandle handle = 0; handle < full.animes.size(); ++handle)
+        fullTrie.insert(full.animes.names()[handle], handle);
+    std::vector<std::pair<std::string, AnimeHandle>> suggestions = trie.getSuggestions(""), expected = fullTrie.getSuggestions("");
+    std::sort(suggestions.begin(), suggestions.end());
+    std::sort(expected.begin(), expected.end());
+    check(suggestions == expected, "Trie", seed);
+
+    std::cout << "semilla " << seed << ": " << base.size() << " filas base, " << delta.size()
+              << " filas en el delta, " << changes.size() << " aplicadas" << std::endl;
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    std::string csvFile = argc > 1 ? argv[1] : "anime.csv";
+    uint64_t seeds = argc > 2 ? std::stoull(argv[2]) : 5;
+
+    std::ifstream in(csvFile, std::ios::binary);
+    if (!in) {
+        std::cerr << "Error al abrir el archivo: " << csvFile << std::endl;
+        return 1;
+    }
+    std::string header, line;
+    std::vector<std::string> rows;
+    std::getline(in, header);
+    if (!header.empty() && header.back() == '\r')
+        header.pop_back();
+    while (std::getline(in, line)) {
+        if (!line.empty() && line.back() == '\r')
+            line.pop_back();
+        if (!line.empty())
+            rows.push_back(line);
+    }
+
+    // Filas que el catálogo acepta
+    Catalog catalog;
+    buildCatalog(csvFile, catalog);
+    std::vector<int> ids = catalog.animes.ids();
+    std::sort(ids.begin(), ids.end());
+    std::vector<bool> valid;
+    std::vector<std::string> validRows;
+    for (const std::string& row : rows) {
+        int id = std::atoi(row.c_str());
+        valid.push_back(std::binary_search(ids.begin(), ids.end(), id));
+        if (valid.back())
+            validRows.push_back(row);
+    }
+
+    std::filesystem::path directory = std::filesystem::temp_directory_path() / "applyDeltaTest";
+    std::filesystem::create_directories(directory);
+    for (uint64_t seed = 1; seed <= seeds; ++seed)
+        runSeed(header, rows, valid, validRows, seed, directory.string());
+    std::filesystem::remove_all(directory);
+
+    std::cout << (failures == 0 ? "applyDelta: OK" : "applyDelta: FALLA") << std::endl;
+    return failures == 0 ? 0 : 1;
+}
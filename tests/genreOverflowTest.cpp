@@ -0,0 +1,112 @@
+// Prueba de un CSV con 65 géneros distintos: la máscara de géneros tiene 64
+// bits, así que la fila del género 65 se informa y se salta, y el resto del
+// archivo se carga igual con cada cargador (readCSV, readCSVParallel,
+// buildCatalog, loadCatalog y los applyDelta).
+//
+// Uso: genreOverflowTest
+
+#include "../utilities.hpp"
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+int failures = 0;
+
+void check(bool condition, const std::string& what)
+{
+    if (!condition) {
+        std::cout << "FALLA: " << what << std::endl;
+        ++failures;
+    }
+}
+
+// La fila i tiene el género "Genero i" y suficientes miembros para el grafo
+void writeCsv(const std::string& filename, int first, int last, const std::string& extraGenre = "")
+{
+    std::ofstream out(filename, std::ios::binary);
+    out << "anime_id,name,genre,type,episodes,rating,members\r\n";
+    for (int i = first; i <= last; ++i) {
+        out << i << ",Anime " << i << ",\"Genero " << i << (extraGenre.empty() ? "" : ", " + extraGenre)
+            << "\",TV,12,7.5,300000\r\n";
+    }
+}
+
+template <typename T>
+std::vector<int> ids(const T& animes)
+{
+    std::vector<int> result;
+    for (const Anime& anime : animes)
+        result.push_back(anime.anime_id);
+    return result;
+}
+
+std::vector<int> range(int first, int last)
+{
+    std::vector<int> result;
+    for (int i = first; i <= last; ++i)
+        result.push_back(i);
+    return result;
+}
+
+} // namespace
+
+int main()
+{
+    // loadCatalog escribe catalog.bin en el directorio actual
+    std::filesystem::path directory = std::filesystem::temp_directory_path() / "genreOverflowTest";
+    std::filesystem::create_directories(directory);
+    std::filesystem::path previous = std::filesystem::current_path();
+    std::filesystem::current_path(directory);
+
+    writeCsv("genres.csv", 1, 65);
+    writeCsv("delta.csv", 66, 66, "Genero 1");
+
+    std::ostringstream errors;
+    std::streambuf* stderrBuffer = std::cerr.rdbuf(errors.rdbuf());
+
+    std::vector<Anime> animes;
+    readCSV("genres.csv", animes);
+    check(ids(animes) == range(1, 64), "readCSV carga las filas de los primeros 64 géneros");
+    check(GenreDictionary::instance().size() == GenreDictionary::MAX_GENRES, "el diccionario queda lleno");
+    check(errors.str().find("anime_id 65") != std::string::npos, "readCSV informa la fila 65");
+
+    std::vector<Anime> parallel;
+    readCSVParallel("genres.csv", parallel, 4);
+    check(ids(parallel) == range(1, 64), "readCSVParallel");
+
+    UndirectedGraphWeight graph;
+    readCSV("genres.csv", graph);
+    check(ids(graph.vertices()) == range(1, 64), "readCSV del grafo");
+
+    Catalog catalog;
+    buildCatalog("genres.csv", catalog);
+    check(catalog.animes.ids() == range(1, 64), "buildCatalog");
+    check(catalog.genre_ids().size() == 64, "géneros del catálogo");
+
+    Catalog loaded;
+    loadCatalog("genres.csv", loaded);
+    check(loaded.animes.ids() == range(1, 64), "loadCatalog del catálogo");
+    std::vector<Anime> loadedAnimes;
+    loadCatalog("genres.csv", loadedAnimes);
+    check(ids(loadedAnimes) == range(1, 64), "loadCatalog del vector");
+
+    // La fila del delta trae un género nuevo: se salta y el catálogo no cambia
+    errors.str("");
+    std::vector<CatalogChange> changes = applyDelta("delta.csv", catalog);
+    check(changes.empty() && catalog.animes.ids() == range(1, 64), "applyDelta del catálogo");
+    applyDelta("delta.csv", graph, 0.5L);
+    check(ids(graph.vertices()) == range(1, 64), "applyDelta del grafo");
+    check(errors.str().find("anime_id 66") != std::string::npos, "applyDelta informa la fila 66");
+
+    std::cerr.rdbuf(stderrBuffer);
+    std::filesystem::current_path(previous);
+    std::filesystem::remove_all(directory);
+
+    std::cout << (failures == 0 ? "genreOverflow: OK" : "genreOverflow: FALLA") << std::endl;
+    return failures == 0 ? 0 : 1;
+}
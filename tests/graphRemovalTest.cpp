@@ -0,0 +1,257 @@
+// Prueba aleatoria de UndirectedGraphWeight: mezcla altas y bajas de vértices y
+// arcos, reemplazos, lotes de add_edges y compactaciones, y compara el grafo
+// con un modelo de referencia (vértices por anime_id y arcos por par de ids).
+// Cubre las lápidas de remove_vertex, la renumeración de compact() y
+// needs_compaction().
+//
+// Uso: graphRemovalTest [anime.csv] [semillas] [operaciones]
+
+#include "../utilities.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <iostream>
+#include <map>
+#include <random>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace {
+
+using Pair = std::pair<int, int>;
+
+Pair key(int a, int b)
+{
+    return { std::min(a, b), std::max(a, b) };
+}
+
+// Modelo de referencia: lo que el grafo debería contener
+struct Model {
+    std::map<int, Anime> vertices;
+    std::map<Pair, float> edges;
+
+    void removeEdgesOf(int id)
+    {
+        for (auto it = edges.begin(); it != edges.end();) {
+            if (it->first.first == id || it->first.second == id)
+                it = edges.erase(it);
+            else
+                ++it;
+        }
+    }
+};
+
+// Salida de la prueba; std::cout se silencia mientras corre, porque los
+// mensajes del grafo (vértice repetido, inexistente...) no interesan aquí
+std::ostream report(std::cout.rdbuf());
+int failures = 0;
+
+void check(bool condition, const std::string& what, unsigned seed, int step)
+{
+    if (!condition) {
+        if (failures < 20)
+            report << "FALLA (semilla " << seed << ", paso " << step << "): " << what << std::endl;
+        ++failures;
+    }
+}
+
+void verify(const UndirectedGraphWeight& graph, const Model& model, unsigned seed, int step)
+{
+    auto fail = [&](bool condition, const std::string& what) { check(condition, what, seed, step); };
+
+    fail(graph.vertex_count() == model.vertices.size(), "cantidad de vértices");
+    fail(graph.edge_list().size() == model.edges.size(), "cantidad de arcos");
+
+    std::map<int, std::multiset<int>> adjacency;
+    for (const auto& [pair, weight] : model.edges) {
+        adjacency[pair.first].insert(pair.second);
+        adjacency[pair.second].insert(pair.first);
+    }
+
+    size_t removed = 0;
+    for (size_t index = 0; index < graph.vertices().size(); ++index) {
+        if (!graph.is_alive(index)) {
+            ++removed;
+            fail(graph.neighbors(index).empty(), "una lápida tiene vecinos");
+            continue;
+        }
+
+        const Anime& anime = graph.vertices()[index];
+        fail(model.vertices.count(anime.anime_id) == 1, "vértice fuera del modelo");
+        fail(graph.find_by_id(anime.anime_id) == std::optional<VertexHandle>(index), "find_by_id");
+
+        // find(título) da el primer vértice vivo con ese título
+        std::optional<VertexHandle> first = graph.find(anime.name);
+        fail(first && *first <= index && graph.is_alive(*first) && graph.vertices()[*first].name == anime.name, "find por título");
+
+        std::multiset<int> neighbors;
+        Span<uint32_t> row = graph.neighbors(index);
+        Span<float> weights = graph.neighbor_weights(index);
+        for (size_t k = 0; k < row.size(); ++k) {
+            fail(graph.is_alive(row[k]), "vecino en una lápida");
+            int other = graph.vertices()[row[k]].anime_id;
+            neighbors.insert(other);
+            auto edge = model.edges.find(key(anime.anime_id, other));
+            fail(edge != model.edges.end() && edge->second == weights[k], "peso en la fila");
+        }
+        const std::multiset<int>& expected = adjacency[anime.anime_id];
+        fail(neighbors == expected, "vecinos de " + std::to_string(anime.anime_id));
+        fail(graph.degree(anime) == expected.size(), "grado");
+    }
+    fail(removed + graph.vertex_count() == graph.vertices().size(), "cantidad de lápidas");
+    fail(!(removed * 4 >= graph.vertices().size() && removed > 0) || graph.needs_compaction(), "needs_compaction con un cuarto de lápidas");
+
+    for (const auto& e : graph.edges()) {
+        auto edge = model.edges.find(key(e.v1.anime_id, e.v2.anime_id));
+        fail(edge != model.edges.end() && edge->second == e.weight, "arco fuera del modelo");
+        fail(graph.weight(e.v1, e.v2) == e.weight && graph.contains_edge(e.v2, e.v1), "weight y contains_edge");
+    }
+
+    // El BFS alcanza la misma componente que en el modelo
+    if (!model.vertices.empty()) {
+        int start = model.vertices.begin()->first;
+        std::set<int> reached{ start };
+        std::vector<int> pending{ start };
+        while (!pending.empty()) {
+            int current = pending.back();
+            pending.pop_back();
+            for (int other : adjacency[current]) {
+                if (reached.insert(other).second)
+                    pending.push_back(other);
+            }
+        }
+        std::vector<Anime> order = graph.bfs(model.vertices.begin()->second);
+        std::set<int> visited;
+        for (const Anime& anime : order)
+            visited.insert(anime.anime_id);
+        fail(visited == reached && order.size() == reached.size(), "componente del BFS");
+    }
+}
+
+void runSeed(const std::vector<Anime>& pool, unsigned seed, int operations)
+{
+    std::mt19937 random(seed);
+    UndirectedGraphWeight graph;
+    Model model;
+    int compactions = 0;
+
+    auto pick = [&]() -> const Anime& { return pool[random() % pool.size()]; };
+    auto has = [&](const Anime& anime) { return model.vertices.count(anime.anime_id) == 1; };
+
+    for (int step = 0; step < operations; ++step) {
+        unsigned kind = random() % 100;
+        const Anime& a = pick();
+        const Anime& b = pick();
+
+        if (kind < 20) {
+            bool added = graph.add_vertex(a);
+            check(added == !has(a), "add_vertex", seed, step);
+            if (added)
+                model.vertices[a.anime_id] = a;
+        } else if (kind < 32) {
+            graph.remove_vertex(a);
+            if (has(a)) {
+                model.vertices.erase(a.anime_id);
+                model.removeEdgesOf(a.anime_id);
+            }
+        } else if (kind < 75) {
+            float weight = float(random() % 1000) / 1000;
+            if (has(a) && has(b) && a.anime_id != b.anime_id && !model.edges.count(key(a.anime_id, b.anime_id)))
+                model.edges[key(a.anime_id, b.anime_id)] = weight;
+            graph.add_edge(a, b, weight);
+        } else if (kind < 88) {
+            model.edges.erase(key(a.anime_id, b.anime_id));
+            graph.remove_edge(a, b);
+        } else if (kind < 92) {
+            Anime replacement = a;
+            replacement.rating += 0.5f;
+            bool replaced = graph.replace_vertex(a, replacement);
+            check(replaced == has(a), "replace_vertex", seed, step);
+            if (replaced) {
+                model.vertices[a.anime_id] = replacement;
+                model.removeEdgesOf(a.anime_id);
+            }
+        } else if (kind < 96) {
+            // Lote con índices al azar: lazos, lápidas, repetidos y arcos ya presentes incluidos
+            size_t size = std::max<size_t>(1, graph.vertices().size());
+            std::vector<edge> batch;
+            for (unsigned k = random() % 40; k > 0; --k)
+                batch.push_back({ uint32_t(random() % size), uint32_t(random() % size), float(random() % 1000) / 1000 });
+
+            std::vector<edge> sorted = batch;
+            std::stable_sort(sorted.begin(), sorted.end(), [](const edge& x, const edge& y) {
+                return EdgeIndex::key(x.v1, x.v2) < EdgeIndex::key(y.v1, y.v2);
+            });
+            std::set<Pair> seen;
+            for (const edge& e : sorted) {
+                if (e.v1 >= graph.vertices().size() || e.v2 >= graph.vertices().size() || e.v1 == e.v2
+                    || !graph.is_alive(e.v1) || !graph.is_alive(e.v2))
+                    continue;
+                Pair pair = key(graph.vertices()[e.v1].anime_id, graph.vertices()[e.v2].anime_id);
+                if (seen.insert(pair).second && !model.edges.count(pair))
+                    model.edges[pair] = e.weight;
+            }
+            graph.add_edges(batch);
+        } else if (graph.needs_compaction() || random() % 10 == 0) {
+            // compact() conserva el orden relativo y devuelve la nueva posición de cada vértice
+            std::vector<int> ids(graph.vertices().size(), -1);
+            for (size_t index = 0; index < ids.size(); ++index) {
+                if (graph.is_alive(index))
+                    ids[index] = graph.vertices()[index].anime_id;
+            }
+            std::vector<VertexHandle> remap = graph.compact();
+            ++compactions;
+
+            check(remap.size() == ids.size() && graph.vertices().size() == model.vertices.size(), "tamaño de compact()", seed, step);
+            VertexHandle next = 0;
+            for (size_t index = 0; index < remap.size(); ++index) {
+                if (ids[index] < 0) {
+                    check(remap[index] == UndirectedGraphWeight::NONE, "lápida sin NONE", seed, step);
+                    continue;
+                }
+                check(remap[index] == next++, "orden de compact()", seed, step);
+                check(graph.vertices()[remap[index]].anime_id == ids[index], "renumeración de compact()", seed, step);
+            }
+            check(!graph.needs_compaction(), "needs_compaction después de compact()", seed, step);
+        }
+
+        if (step % 50 == 0)
+            verify(graph, model, seed, step);
+    }
+    verify(graph, model, seed, operations);
+
+    // Un vértice que no está en el grafo no tiene vecinos
+    Anime missing = pool.front();
+    missing.anime_id = -1;
+    check(graph.neighbors(missing).empty() && graph.degree(missing) == 0, "vecinos de un vértice ausente", seed, operations);
+
+    report << "semilla " << seed << ": " << graph.vertex_count() << " vértices, "
+              << graph.edge_list().size() << " arcos, " << compactions << " compactaciones" << std::endl;
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    std::string csvFile = argc > 1 ? argv[1] : "anime.csv";
+    unsigned seeds = argc > 2 ? std::stoul(argv[2]) : 5;
+    int operations = argc > 3 ? std::stoi(argv[3]) : 20000;
+
+    // Pocos animes, para que las altas, bajas y arcos se repitan
+    std::vector<Anime> pool;
+    readCSV(csvFile, pool);
+    if (pool.empty()) {
+        std::cerr << "No se leyeron animes de " << csvFile << std::endl;
+        return 1;
+    }
+    pool.resize(std::min<size_t>(pool.size(), 400));
+
+    std::streambuf* output = std::cout.rdbuf(nullptr);
+    for (unsigned seed = 1; seed <= seeds; ++seed)
+        runSeed(pool, seed, operations);
+    std::cout.rdbuf(output);
+
+    report << (failures == 0 ? "graphRemoval: OK" : "graphRemoval: FALLA") << std::endl;
+    return failures == 0 ? 0 : 1;
+}
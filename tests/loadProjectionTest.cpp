@@ -0,0 +1,100 @@
+// Prueba de las opciones de carga: la misma proyección y los mismos filtros
+// cargados con loadCatalog desde catalog.bin y con readCSV desde el CSV deben
+// dar exactamente los mismos animes, con las columnas no proyectadas vacías.
+//
+// Uso: loadProjectionTest [anime.csv]
+
+#include "../utilities.hpp"
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace {
+
+int failures = 0;
+
+void check(bool condition, const std::string& what)
+{
+    if (!condition) {
+        std::cout << "FALLA: " << what << std::endl;
+        ++failures;
+    }
+}
+
+bool sameAnime(const Anime& a, const Anime& b)
+{
+    return a.anime_id == b.anime_id && a.name == b.name && a.genres == b.genres && a.genreMask == b.genreMask
+        && a.type == b.type && a.episodes == b.episodes && a.rating == b.rating && a.members == b.members;
+}
+
+bool sameAnimes(const std::vector<Anime>& a, const std::vector<Anime>& b)
+{
+    if (a.size() != b.size())
+        return false;
+    for (size_t i = 0; i < a.size(); ++i) {
+        if (!sameAnime(a[i], b[i]))
+            return false;
+    }
+    return true;
+}
+
+// Las columnas de texto que no se proyectan quedan vacías
+bool projected(const std::vector<Anime>& animes, const LoadOptions& options)
+{
+    for (const Anime& anime : animes) {
+        if ((!options.has(COL_NAME) && !anime.name.empty())
+            || (!options.has(COL_GENRES) && (!anime.genres.empty() || anime.genreMask != 0))
+            || (!options.has(COL_TYPE) && !anime.type.empty()))
+            return false;
+    }
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    std::string csvFile = std::filesystem::absolute(argc > 1 ? argv[1] : "anime.csv").string();
+
+    // loadCatalog escribe catalog.bin en el directorio actual
+    std::filesystem::path directory = std::filesystem::temp_directory_path() / "loadProjectionTest";
+    std::filesystem::create_directories(directory);
+    std::filesystem::path previous = std::filesystem::current_path();
+    std::filesystem::current_path(directory);
+
+    struct Case {
+        std::string name;
+        LoadOptions options;
+    };
+    std::vector<Case> cases = {
+        { "todas las columnas", LoadOptions() },
+        { "solo ids", LoadOptions().project({ COL_ID }) },
+        { "títulos", LoadOptions().project({ COL_ID, COL_NAME }) },
+        { "géneros y tipo", LoadOptions().project({ COL_GENRES, COL_TYPE }) },
+        { "títulos de los populares", LoadOptions().project({ COL_NAME }).where(COL_MEMBERS, 100000) },
+        { "géneros con puntaje alto", LoadOptions().project({ COL_GENRES }).where(COL_RATING, 8.0, 9.0) },
+    };
+
+    for (const Case& test : cases) {
+        std::vector<Anime> fromCsv, fromSnapshot;
+        readCSV(csvFile, fromCsv, test.options);
+        loadCatalog(csvFile, fromSnapshot, test.options);
+        check(std::filesystem::exists("catalog.bin"), "loadCatalog no escribió catalog.bin (" + test.name + ")");
+        check(!fromCsv.empty() && sameAnimes(fromCsv, fromSnapshot), "snapshot y CSV difieren (" + test.name + ")");
+        check(projected(fromSnapshot, test.options), "columnas no proyectadas en el snapshot (" + test.name + ")");
+        check(projected(fromCsv, test.options), "columnas no proyectadas en el CSV (" + test.name + ")");
+    }
+
+    // El grafo usa su filtro de miembros por defecto
+    UndirectedGraphWeight fromCsv, fromSnapshot;
+    readCSV(csvFile, fromCsv);
+    loadCatalog(csvFile, fromSnapshot);
+    check(sameAnimes(fromCsv.vertices(), fromSnapshot.vertices()), "vértices del grafo");
+
+    std::filesystem::current_path(previous);
+    std::filesystem::remove_all(directory);
+
+    std::cout << (failures == 0 ? "loadProjection: OK" : "loadProjection: FALLA") << std::endl;
+    return failures == 0 ? 0 : 1;
+}
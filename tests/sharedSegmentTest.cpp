@@ -0,0 +1,176 @@
+// Prueba de SharedSegment: publica el catálogo y el grafo en memoria compartida,
+// se conecta como lector, vuelve a publicar y comprueba que el lector vea la
+// generación nueva, que las viejas se eliminen, que publicaciones simultáneas
+// dejen la generación más alta (el CAS del segmento de control) y que attach
+// rechace un segmento con el encabezado dañado o que ya no existe. También
+// comprueba que loadCatalog use el catálogo compartido en vez de catalog.bin.
+//
+// Uso: sharedSegmentTest [anime.csv]
+
+#include "../utilities.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace {
+
+int failures = 0;
+
+void check(bool condition, const std::string& what)
+{
+    if (!condition) {
+        std::cout << "FALLA: " << what << std::endl;
+        ++failures;
+    }
+}
+
+std::string segmentName(const std::string& name, uint64_t generation)
+{
+    return name + "." + std::to_string(generation);
+}
+
+bool segmentExists(const std::string& name, uint64_t generation)
+{
+    int fd = ::shm_open(segmentName(name, generation).c_str(), O_RDONLY, 0);
+    if (fd < 0)
+        return false;
+    ::close(fd);
+    return true;
+}
+
+// Sobrescribe bytes del segmento de una generación; devuelve los que había
+std::vector<char> patch(const std::string& name, uint64_t generation, size_t offset, const std::vector<char>& bytes)
+{
+    std::vector<char> old(bytes.size());
+    int fd = ::shm_open(segmentName(name, generation).c_str(), O_RDWR, 0);
+    if (fd < 0)
+        return old;
+    void* address = ::mmap(nullptr, offset + bytes.size(), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (address == MAP_FAILED)
+        return old;
+    char* base = static_cast<char*>(address);
+    std::copy(base + offset, base + offset + bytes.size(), old.begin());
+    std::copy(bytes.begin(), bytes.end(), base + offset);
+    ::munmap(address, offset + bytes.size());
+    return old;
+}
+
+// El lector ve el mismo catálogo y los mismos arcos que se publicaron
+bool sameContents(const SharedSegment& reader, const Catalog& catalog, const UndirectedGraphWeight& graph)
+{
+    const CatalogSnapshot& snapshot = reader.catalog();
+    if (snapshot.size() != catalog.animes.size() || reader.vertex_count() != graph.vertices().size())
+        return false;
+    for (size_t i = 0; i < snapshot.size(); ++i) {
+        if (snapshot.anime_id(i) != catalog.animes.ids()[i] || snapshot.name(i) != catalog.animes.names()[i])
+            return false;
+    }
+    for (size_t v = 0; v < graph.vertices().size(); ++v) {
+        if (!graph.is_alive(v)) {
+            if (reader.anime(v) != SharedSegment::NONE || !reader.neighbors(v).empty())
+                return false;
+            continue;
+        }
+        if (snapshot.anime_id(reader.anime(v)) != graph.vertices()[v].anime_id)
+            return false;
+        Span<uint32_t> expected = graph.neighbors(v), actual = reader.neighbors(v);
+        Span<float> expectedWeights = graph.neighbor_weights(v), actualWeights = reader.neighbor_weights(v);
+        if (!std::equal(expected.begin(), expected.end(), actual.begin(), actual.end())
+            || !std::equal(expectedWeights.begin(), expectedWeights.end(), actualWeights.begin(), actualWeights.end()))
+            return false;
+    }
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    std::string csvFile = std::filesystem::absolute(argc > 1 ? argv[1] : "anime.csv").string();
+    const std::string name = "/sharedSegmentTest." + std::to_string(::getpid());
+    const long double threshold = 0.8L;
+
+    // publishCatalog escribe catalog.bin y graph.bin en el directorio actual
+    std::filesystem::path directory = std::filesystem::temp_directory_path() / "sharedSegmentTest";
+    std::filesystem::create_directories(directory);
+    std::filesystem::path previous = std::filesystem::current_path();
+    std::filesystem::current_path(directory);
+
+    Catalog catalog;
+    buildCatalog(csvFile, catalog);
+    UndirectedGraphWeight graph;
+    readCSV(csvFile, graph);
+    buildGraph(graph, threshold);
+
+    // Publicar y conectarse
+    SharedSegment reader;
+    check(!reader.attach(name), "attach sin nada publicado");
+    uint64_t first = publishCatalog(csvFile, name, threshold);
+    check(first > 0, "publishCatalog");
+    check(reader.attach(name) && reader.generation() == first && reader.is_current(), "attach a la primera generación");
+    check(sameContents(reader, catalog, graph), "contenido de la primera generación");
+
+    // Publicar otra vez, con un vértice menos: el lector sigue en la suya hasta reconectarse
+    graph.remove_vertex(graph.vertices()[0]);
+    uint64_t second = SharedSegment::publish(name, catalog, graph, csvFile);
+    check(second > first, "la segunda generación es mayor");
+    check(!reader.is_current() && reader.generation() == first, "el lector ve que su generación es vieja");
+    check(reader.catalog().size() == catalog.animes.size(), "la generación vieja sigue mapeada");
+    check(!segmentExists(name, first), "la generación vieja se elimina");
+    check(reader.attach(name) && reader.generation() == second && reader.is_current(), "attach a la segunda generación");
+    check(sameContents(reader, catalog, graph), "contenido de la segunda generación");
+
+    // Publicaciones simultáneas: queda la generación más alta y las demás se eliminan
+    std::vector<uint64_t> generations(8);
+    std::vector<std::thread> publishers;
+    for (size_t p = 0; p < generations.size(); ++p)
+        publishers.emplace_back([&, p]() { generations[p] = SharedSegment::publish(name, catalog, graph, csvFile); });
+    for (auto& publisher : publishers)
+        publisher.join();
+    uint64_t last = *std::max_element(generations.begin(), generations.end());
+    check(std::find(generations.begin(), generations.end(), 0) == generations.end(), "publicaciones simultáneas");
+    check(reader.attach(name) && reader.generation() == last, "attach a la generación más alta");
+    for (uint64_t generation = first; generation < last; ++generation)
+        check(!segmentExists(name, generation), "generación " + std::to_string(generation) + " sin eliminar");
+
+    // Encabezado dañado. Empieza con magic (8 bytes), version (4), vertexCount (4) y generation (8)
+    std::vector<char> version = patch(name, last, 8, { 'x', 'x', 'x', 'x' });
+    check(!SharedSegment().attach(name), "attach con la versión dañada");
+    patch(name, last, 8, version);
+    std::vector<char> generation = patch(name, last, 16, std::vector<char>(8, 0));
+    check(!SharedSegment().attach(name), "attach con la generación de otro segmento");
+    patch(name, last, 16, generation);
+    std::vector<char> magic = patch(name, last, 0, { '?' });
+    check(!SharedSegment().attach(name), "attach con el magic dañado");
+    patch(name, last, 0, magic);
+    check(SharedSegment().attach(name), "attach con el encabezado restaurado");
+
+    // loadCatalog usa el catálogo compartido: no escribe catalog.bin
+    std::filesystem::remove("catalog.bin");
+    check(attachSharedCatalog(name) == last, "attachSharedCatalog");
+    Catalog shared;
+    loadCatalog(csvFile, shared);
+    check(!std::filesystem::exists("catalog.bin") && shared.animes.ids() == catalog.animes.ids()
+          && shared.animes.names() == catalog.animes.names(), "loadCatalog desde el catálogo compartido");
+
+    // Una generación que ya no existe no se puede conectar
+    SharedSegment::remove(name);
+    check(!SharedSegment().attach(name), "attach después de remove");
+    check(reader.catalog().size() == catalog.animes.size(), "el lector conserva su mapeo después de remove");
+    reader.detach();
+    sharedCatalog().segment.detach();
+
+    std::filesystem::current_path(previous);
+    std::filesystem::remove_all(directory);
+
+    std::cout << (failures == 0 ? "sharedSegment: OK" : "sharedSegment: FALLA") << std::endl;
+    return failures == 0 ? 0 : 1;
+}
@@ -2,6 +2,11 @@
 #define UTILITIES_HPP
 
 #include "anime.hpp"
+#include "csvReader.hpp"
+#include "catalog.hpp"
+#include "catalogSnapshot.hpp"
+#include "graphSnapshot.hpp"
+#include "sharedSegment.hpp"
 #include "dataStructures/undirectedGraphWeight.hpp"
 #include "dataStructures/trie.hpp"
 #include "dataStructures/avl_tree.hpp"
@@ -15,215 +20,345 @@
 #include <type_traits>
 #include <chrono>
 #include <set>
+#include <thread>
+#include <iterator>
+#include <optional>
 
 enum option {BFS, DFS, EXIT, YES};
 
+// Mínimo de miembros para que un anime sea vértice del grafo de similitud
+constexpr int GRAPH_MIN_MEMBERS = 200000;
+
+// Opciones de carga por defecto de cada estructura: el grafo solo guarda los animes populares
+template <typename T>
+LoadOptions loadOptionsFor() {
+    LoadOptions options;
+    if constexpr (std::is_same<T, UndirectedGraphWeight>::value)
+        options.where(COL_MEMBERS, GRAPH_MIN_MEMBERS);
+    return options;
+}
+
+// Las filas se filtran (options.filters) antes de decodificarlas y solo las
+// columnas proyectadas (options.columns) se copian en cada Anime. Una fila con
+// géneros que no caben en el diccionario se informa y se salta.
 template <typename T>
-void readCSV(const std::string& filename, T &dataStructure) {
-    std::ifstream file(filename);
-    std::string line;
+void readCSV(const std::string& filename, T &dataStructure, const LoadOptions& options = loadOptionsFor<T>()) {
+    MappedFile file(filename);
 
     if (!file.is_open()) {
         std::cerr << "Error al abrir el archivo: " << filename << std::endl;
         return;
     }
-    
-    unsigned lineNumber = 1; // Just for debuging
-    std::getline(file, line);
-
-    while (std::getline(file, line)) {
-        // Atributes variables
-        std::string name, genres, type;
-        int id = 0, episodes = -1, members = -1;
-        float rating = -1.0f;
-       
-        // Control variables
-        std::stringstream ss(line); // Use to read line
-        std::string data; // Variable to store the information of CSV
-
-        ++lineNumber; // Counts line in case of especial error in CSV
-        //std::cout << "Line: " << lineNumber << std::endl;
-       
-        // Save ID
-        std::getline(ss, data, ','); // Read the first line and saves it in data
-        id = stoi(data);
-
-        // Leer el campo "name" (manejar nombres con y sin comillas)
-        std::getline(ss, name, ',');
-        if (name[0] == '"') {
-            while (name.back() != '"') {
-                std::string temp;
-                std::getline(ss, temp, ',');
-                name += "," + temp;
-            }
-            name = name.substr(1, name.size() - 2); // Quitar comillas
-        }
 
-        // Leer el campo "genre" (manejar géneros con y sin comillas)
-        std::getline(ss, genres, ',');
-        if (genres[0] == '"') {
-            while (genres.back() != '"') {
-                std::string temp;
-                std::getline(ss, temp, ',');
-                genres += "," + temp;
-            }
-            genres = genres.substr(1, genres.size() - 2); // Quitar comillas
-        }
-        
-        // Checa si existen generos
-        if (genres == "")
-            continue;
-        
-        // Separar los géneros en subcategorías y limpiarlos
-        std::stringstream genreStream(genres);
-        std::string genre;
-        std::vector<std::string> vectorGenre;
-        while (std::getline(genreStream, genre, ',')) {
-            // Eliminar espacios al inicio y al final de cada género
-            genre.erase(0, genre.find_first_not_of(" "));
-            genre.erase(genre.find_last_not_of(" ") + 1);
-            vectorGenre.push_back(genre);
-        }
-        
-        // Save type
-        getline(ss, data, ',');
-        type = data;
-        if (type == "")
-            continue;
+    CsvCursor cursor(file.data());
+    cursor.next_record(); // Saltar el encabezado
 
-        // Save episodes
-        getline(ss, data, ',');
-        episodes = data != "Unknown" ? stoi(data) : -1;
-        if (episodes < 0) 
-            continue;
-        
-        // Save rating
-        getline(ss, data, ',');
-        rating = data != "" ? stof(data) : -1.0f;
-        if (rating < 0)
+    AnimeRecord record;
+    while (!cursor.done()) {
+        // Tokenizar la fila sin copiarla; las filas inválidas o filtradas se saltan
+        if (!readAnimeRecord(cursor, record, options))
             continue;
 
-        // Save members
-        getline(ss, data, ',');
-        members = stoi(data);
-        
-        
-        // Create anime object
-        Anime anime(id, name, vectorGenre, type, episodes, rating, members);
-        
-        if constexpr (std::is_same<T, std::vector<Anime>>::value) {
-            dataStructure.push_back(anime); // Agregar al vector
-        } else if constexpr (std::is_same<T, UndirectedGraphWeight>::value) {
-            if (members < 200000)
-                continue;
-            dataStructure.add_vertex(anime); // Create a node on graph
+        try {
+            if constexpr (std::is_same<T, std::vector<Anime>>::value) {
+                dataStructure.push_back(toAnime(record, options.columns)); // Agregar al vector
+            } else if constexpr (std::is_same<T, UndirectedGraphWeight>::value) {
+                dataStructure.add_vertex(toAnime(record, options.columns)); // Create a node on graph
+            }
+        } catch (const std::runtime_error& error) {
+            reportSkippedRow(record.anime_id, error);
         }
     }
-    file.close();
 }
 
-// Use vector to storage elements
+// Versión paralela de readCSV: el archivo se parte en rangos de bytes en los
+// límites de registro, cada rango se lee en su propio hilo y los resultados se
+// unen en el orden del archivo, así que el resultado es idéntico a readCSV.
 template <typename T>
-void extractUniques(const std::string& filename, T& uniqueGenre, T& uniqueTypes) {
-    std::ifstream file(filename);
-    std::string line;
+void readCSVParallel(const std::string& filename, T &dataStructure,
+                     unsigned threads = std::thread::hardware_concurrency(),
+                     const LoadOptions& options = loadOptionsFor<T>()) {
+    MappedFile file(filename);
 
     if (!file.is_open()) {
         std::cerr << "Error al abrir el archivo: " << filename << std::endl;
         return;
     }
 
+    threads = std::max(1u, threads);
+
+    CsvCursor header(file.data());
+    header.next_record(); // Saltar el encabezado
+    std::string_view body = file.data().substr(header.position());
+
+    std::vector<size_t> bounds = findRecordBoundaries(body, threads);
+    std::vector<std::vector<Anime>> parts(threads);
+    std::vector<std::vector<std::pair<int, std::runtime_error>>> skipped(threads);
+    std::vector<std::thread> workers;
+
+    for (unsigned p = 0; p < threads; ++p) {
+        workers.emplace_back([&, p]() {
+            CsvCursor cursor(body.substr(bounds[p], bounds[p + 1] - bounds[p]));
+            AnimeRecord record;
+            while (!cursor.done()) {
+                if (!readAnimeRecord(cursor, record, options))
+                    continue;
+                try {
+                    parts[p].push_back(toAnime(record, options.columns));
+                } catch (const std::runtime_error& error) {
+                    skipped[p].emplace_back(record.anime_id, error);
+                }
+            }
+        });
+    }
+    for (auto& worker : workers)
+        worker.join();
+
+    // Las filas saltadas se informan al final, en el orden del archivo
+    for (const auto& part : skipped)
+        for (const auto& [animeId, error] : part)
+            reportSkippedRow(animeId, error);
+
+    // Unir los rangos en el orden del archivo
+    if constexpr (std::is_same<T, std::vector<Anime>>::value) {
+        size_t total = dataStructure.size();
+        for (const auto& part : parts)
+            total += part.size();
+        dataStructure.reserve(total);
+        for (auto& part : parts)
+            std::move(part.begin(), part.end(), std::back_inserter(dataStructure));
+    } else if constexpr (std::is_same<T, UndirectedGraphWeight>::value) {
+        for (const auto& part : parts)
+            for (const auto& anime : part)
+                dataStructure.add_vertex(anime);
+    }
+}
 
-    std::getline(file, line);
+// Convierte el catálogo del CSV en el snapshot binario que usa loadCatalog
+bool convertCatalog(const std::string& csvFile, const std::string& snapshotFile) {
+    Catalog catalog;
+    return buildCatalog(csvFile, catalog) && CatalogSnapshot::write(snapshotFile, catalog, csvFile);
+}
 
-    while (std::getline(file, line)) {
-        std::stringstream ss(line);
-        std::string data, name, genres, types;
+// Nombre por defecto del catálogo publicado en memoria compartida
+const std::string SHARED_CATALOG = "/anime-recommender";
 
+// Catálogo publicado (publishCatalog) al que se conectó el programa con attachSharedCatalog
+struct SharedCatalog {
+    std::string name;
+    SharedSegment segment;
+};
 
-        std::getline(ss, data, ',');
-        // Leer el campo "name" (manejar nombres con y sin comillas)
-        std::getline(ss, name, ',');
-        if (name[0] == '"') {
-            while (name.back() != '"') {
-                std::string temp;
-                std::getline(ss, temp, ',');
-                name += "," + temp;
-            }
-            name = name.substr(1, name.size() - 2);  // Quitar comillas
+SharedCatalog& sharedCatalog() {
+    static SharedCatalog shared;
+    return shared;
+}
+
+// Se conecta al catálogo publicado en memoria compartida; desde entonces loadCatalog
+// lo usa en vez de catalog.bin. Devuelve la generación, o 0 si no hay uno publicado.
+uint64_t attachSharedCatalog(const std::string& segmentName = SHARED_CATALOG) {
+    SharedCatalog& shared = sharedCatalog();
+    shared.name = segmentName;
+    shared.segment.attach(segmentName);
+    return shared.segment.generation();
+}
+
+// Snapshot del catálogo compartido si se publicó con este CSV (y el CSV no cambió desde
+// entonces), o nullptr. Si ya se publicó una generación nueva, se conecta a ella.
+const CatalogSnapshot* sharedSnapshot(const std::string& csvFile) {
+    SharedCatalog& shared = sharedCatalog();
+    if (shared.segment.is_attached() && !shared.segment.is_current())
+        shared.segment.attach(shared.name);
+    if (!shared.segment.is_attached() || !shared.segment.catalog().built_from(csvFile))
+        return nullptr;
+    return &shared.segment.catalog();
+}
+
+// Carga el catálogo desde el catálogo compartido, si el programa se conectó a uno, o
+// desde catalog.bin, reconstruyendo antes el snapshot si no existe o está
+// desactualizado. Si el snapshot no se puede escribir, se lee el CSV.
+template <typename T>
+void loadCatalog(const std::string& csvFile, T &dataStructure, const LoadOptions& options = loadOptionsFor<T>()) {
+    const std::string snapshotFile = "catalog.bin";
+    CatalogSnapshot file;
+    const CatalogSnapshot* shared = sharedSnapshot(csvFile);
+
+    if (shared == nullptr && !file.open(snapshotFile, csvFile)) {
+        if (!convertCatalog(csvFile, snapshotFile) || !file.open(snapshotFile, csvFile)) {
+            if constexpr (std::is_same<T, Catalog>::value)
+                buildCatalog(csvFile, dataStructure);
+            else
+                readCSV(csvFile, dataStructure, options);
+            return;
         }
-        
-        // Leer el campo "genre" (manejar géneros con y sin comillas)
-        std::getline(ss, genres, ',');
-        if (genres[0] == '"') {
-            while (genres.back() != '"') {
-                std::string temp;
-                std::getline(ss, temp, ',');
-                genres += "," + temp;
-            }
-            genres = genres.substr(1, genres.size() - 2);  // Quitar comillas
+    }
+    const CatalogSnapshot& snapshot = shared ? *shared : file;
+
+    if constexpr (std::is_same<T, Catalog>::value) {
+        // Si los géneros del snapshot no caben en el diccionario, se lee el CSV,
+        // que informa y salta solo las filas que no caben
+        try {
+            snapshot.read(dataStructure);
+        } catch (const std::runtime_error& error) {
+            std::cerr << "No se pudo leer el snapshot del catálogo: " << error.what() << std::endl;
+            buildCatalog(csvFile, dataStructure);
         }
+        return;
+    }
 
-        // Separar los géneros en subcategorías y limpiarlos
-        std::stringstream genreStream(genres);
-        std::string genre;
-        while (std::getline(genreStream, genre, ',')) {
-            // Eliminar espacios al inicio y al final de cada género
-            genre.erase(0, genre.find_first_not_of(" "));
-            genre.erase(genre.find_last_not_of(" ") + 1);
-
-            // Verificar si el género ya está en genresArray
-            bool exists = false;
-            for (int i = 0; i < uniqueGenre.size(); ++i) {
-                if (uniqueGenre[i] == genre) {
-                    exists = true;
-                    break;
-                }
-            }
-
-            // Agregar género si no existe en genresArray
-            if (!exists) {
-                uniqueGenre.push_back(genre);
+    for (size_t i = 0; i < snapshot.size(); ++i) {
+        // Recorrido por columnas: las filas filtradas no se decodifican y de las
+        // demás solo se leen las columnas proyectadas, como en readCSV
+        if (!options.accepts(snapshot.anime_id(i), snapshot.episodes(i), snapshot.rating(i), snapshot.members(i)))
+            continue;
+        try {
+            if constexpr (std::is_same<T, std::vector<Anime>>::value) {
+                dataStructure.push_back(snapshot.anime(i, options.columns));
+            } else if constexpr (std::is_same<T, UndirectedGraphWeight>::value) {
+                dataStructure.add_vertex(snapshot.anime(i, options.columns));
             }
+        } catch (const std::runtime_error& error) {
+            reportSkippedRow(snapshot.anime_id(i), error);
         }
+    }
+}
 
-        // Leer el campo "type" (manejar tipos con y sin comillas)
-        std::getline(ss, types, ',');
-        if (types[0] == '"') {
-            while (types.back() != '"') {
-                std::string temp;
-                std::getline(ss, temp, ',');
-                types += "," + temp;
-            }
-            types = types.substr(1, types.size() - 2);  // Quitar comillas
+// Construye los arcos de un grafo recién cargado. Se leen de graph.bin si se guardó
+// con el mismo umbral, pesos y vértices; si no, se corre buildGraphParallel y se
+// reescribe el snapshot. Devuelve true si se usó el snapshot.
+bool loadGraph(UndirectedGraphWeight& graph, long double threshold, const SimilarityWeights& weights = SimilarityWeights()) {
+    const std::string snapshotFile = "graph.bin";
+
+    // El snapshot tiene la lista de arcos completa, así que solo sirve para un grafo sin arcos
+    if (!graph.edge_list().empty()) {
+        buildGraphParallel(graph, threshold, std::thread::hardware_concurrency(), weights);
+        return false;
+    }
+
+    GraphSnapshot snapshot;
+    if (snapshot.open(snapshotFile, graph, threshold, weights)) {
+        snapshot.read(graph);
+        return true;
+    }
+
+    buildGraphParallel(graph, threshold, std::thread::hardware_concurrency(), weights);
+    GraphSnapshot::write(snapshotFile, graph, threshold, weights);
+    return false;
+}
+
+// Publica el catálogo y el grafo de similitud de un CSV en memoria compartida, para
+// que otros procesos se conecten (attachSharedCatalog) en vez de cargar su propia
+// copia. Devuelve la nueva generación, o 0 si hubo un error.
+uint64_t publishCatalog(const std::string& csvFile, const std::string& segmentName, long double threshold) {
+    Catalog catalog;
+    loadCatalog(csvFile, catalog);
+
+    UndirectedGraphWeight graph;
+    loadCatalog(csvFile, graph);
+    loadGraph(graph, threshold);
+
+    return SharedSegment::publish(segmentName, catalog, graph, csvFile);
+}
+
+// Actualiza un Trie construido con el catálogo con las filas que aplicó applyDelta.
+// Como en un Trie construido desde cero, cada título (en minúsculas) queda con el
+// último anime que lo tiene, así que los títulos tocados se resuelven con una
+// pasada por la columna de nombres
+void applyDelta(const std::vector<CatalogChange>& changes, const Catalog& catalog, Trie& trie) {
+    const AnimeCatalog& animes = catalog.animes;
+    auto lower = [](std::string_view name, std::string& out) {
+        out.assign(name);
+        for (char& c : out)
+            c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+    };
+
+    std::unordered_map<std::string, std::optional<AnimeHandle>> titles;
+    std::string title;
+    for (const CatalogChange& change : changes) {
+        if (!change.added) {
+            lower(change.oldName, title);
+            titles.emplace(title, std::nullopt);
         }
+        lower(animes.names()[change.handle], title);
+        titles.emplace(title, std::nullopt);
+    }
 
-        // Separar los géneros en subcategorías y limpiarlos
-        std::stringstream typeStream(types);
-        std::string type;
-        while (std::getline(typeStream, type, ',')) {
-            // Eliminar espacios al inicio y al final de cada género
-            type.erase(0, type.find_first_not_of(" "));
-            type.erase(type.find_last_not_of(" ") + 1);
-
-            // Verificar si el género ya está en uniqueTypes
-            bool exists = false;
-            for (int i = 0; i < uniqueTypes.size(); ++i) {
-                if (uniqueTypes[i] == type) {
-                    exists = true;
-                    break;
-                }
-            }
+    for (AnimeHandle anime = 0; anime < animes.size(); ++anime) {
+        lower(animes.names()[anime], title);
+        auto it = titles.find(title);
+        if (it != titles.end())
+            it->second = anime;
+    }
 
-            // Agregar género si no existe en uniqueTypes
-            if (!exists) {
-                uniqueTypes.push_back(type);
-            }
+    for (const auto& [name, anime] : titles) {
+        if (anime)
+            trie.insert(name, *anime);
+        else
+            trie.remove(name);
+    }
+}
+
+// Actualiza el AVL de géneros construido con el catálogo con las filas que aplicó
+// applyDelta; las listas quedan ordenadas por handle, como en Catalog::postings
+void applyDelta(const std::vector<CatalogChange>& changes, const Catalog& catalog,
+                AVLTree<std::string, std::vector<AnimeHandle>>& categoryAVL) {
+    const GenreDictionary& genres = GenreDictionary::instance();
+    for (const CatalogChange& change : changes) {
+        uint64_t newMask = catalog.animes.genre_masks()[change.handle];
+
+        for (uint64_t mask = change.oldMask & ~newMask; mask != 0; mask &= mask - 1) {
+            std::vector<AnimeHandle>& animes = categoryAVL[genres.name(__builtin_ctzll(mask))];
+            auto it = std::lower_bound(animes.begin(), animes.end(), change.handle);
+            if (it != animes.end() && *it == change.handle)
+                animes.erase(it);
+        }
+        for (uint64_t mask = newMask & ~change.oldMask; mask != 0; mask &= mask - 1) {
+            std::vector<AnimeHandle>& animes = categoryAVL[genres.name(__builtin_ctzll(mask))];
+            animes.insert(std::lower_bound(animes.begin(), animes.end(), change.handle), change.handle);
+        }
+    }
+}
+
+// Aplica un CSV delta a un grafo construido con readCSV/loadCatalog y buildGraph.
+// Los ids nuevos se agregan como vértices, los existentes se actualizan en su lugar (o se
+// eliminan si ya no pasan el filtro de miembros) y solo se recalculan los arcos de esos
+// vértices, así que quedan los mismos arcos que reconstruyendo el catálogo combinado.
+void applyDelta(const std::string& deltaFile, UndirectedGraphWeight& graph, long double threshold) {
+    std::vector<Anime> delta;
+    readCSV(deltaFile, delta);
+    LoadOptions graphOptions = loadOptionsFor<UndirectedGraphWeight>();
+
+    std::vector<int> changedIds;
+    for (const Anime& anime : delta) {
+        std::optional<VertexHandle> vertex = graph.find_by_id(anime.anime_id);
+        bool keep = graphOptions.accepts(anime.anime_id, anime.episodes, anime.rating, anime.members);
+
+        // Solo se recalculan los arcos de las filas que el grafo aceptó
+        bool applied = false;
+        if (!vertex) {
+            if (!keep)
+                continue;
+            applied = graph.add_vertex(anime);
+        } else if (keep) {
+            applied = graph.replace_vertex(graph.vertices()[*vertex], anime);
+        } else {
+            graph.remove_vertex(graph.vertices()[*vertex]); // Deja una lápida, O(grado)
+            continue;
         }
+        if (applied)
+            changedIds.push_back(anime.anime_id);
+    }
+
+    std::vector<size_t> changed;
+    for (int id : changedIds) {
+        if (std::optional<VertexHandle> vertex = graph.find_by_id(id))
+            changed.push_back(*vertex);
     }
+    extendGraph(graph, changed, threshold);
 
-    file.close();
-    return;
+    // Compactación periódica: se eliminan las lápidas cuando se acumulan
+    if (graph.needs_compaction())
+        graph.compact();
 }
 
 // Time execution in nanoseconds
@@ -238,14 +373,15 @@ unsigned timeExecuation(Func func)
 
 void construirTrie() {
     // Leer los datos del archivo CSV
-    std::vector<Anime> animes;
-    readCSV("anime.csv", animes);
+    Catalog catalog;
+    loadCatalog("anime.csv", catalog);
+    const AnimeCatalog& animes = catalog.animes;
 
     // Construir el Trie y medir el tiempo de construcción
     Trie trie;
     auto buildTime = timeExecuation([&]() {
-        for (auto& anime : animes) {
-            trie.insert(anime.name, &anime);
+        for (AnimeHandle anime = 0; anime < animes.size(); ++anime) {
+            trie.insert(animes.names()[anime], anime);
         }
     });
     std::cout << "Tiempo para construir el Trie: " << buildTime / 1e6 << " ms\n";
@@ -285,8 +421,7 @@ void construirTrie() {
             std::cin.ignore(); // Limpiar el buffer
 
             if (choice > 0 && choice <= static_cast<int>(suggestions.size())) {
-                Anime* selectedAnime = suggestions[choice - 1].second;
-                selectedAnime->display();
+                animes[suggestions[choice - 1].second].display();
             } else {
                 std::cout << "Selección cancelada.\n";
             }
@@ -296,114 +431,42 @@ void construirTrie() {
     }
 }
 
-void extractUniqueGenres(const std::string& filename, DynamicArray<std::string>& genresArray)
-{
-    std::ifstream file(filename);
-    std::string line;
-
-    if (!file.is_open()) {
-        std::cerr << "Error al abrir el archivo: " << filename << std::endl;
-        return;
-    }
-
-
-    std::getline(file, line);
-
-    while (std::getline(file, line)) {
-        std::stringstream ss(line);
-        std::string data, name, genres;
-
-
-        std::getline(ss, data, ',');
-
-        // Leer el campo "name" (manejar nombres con y sin comillas)
-        std::getline(ss, name, ',');
-        if (name[0] == '"') {
-            while (name.back() != '"') {
-                std::string temp;
-                std::getline(ss, temp, ',');
-                name += "," + temp;
-            }
-            name = name.substr(1, name.size() - 2);  // Quitar comillas
-        }
-
-        // Leer el campo "genre" (manejar géneros con y sin comillas)
-        std::getline(ss, genres, ',');
-        if (genres[0] == '"') {
-            while (genres.back() != '"') {
-                std::string temp;
-                std::getline(ss, temp, ',');
-                genres += "," + temp;
-            }
-            genres = genres.substr(1, genres.size() - 2);  // Quitar comillas
-        }
-
-        // Separar los géneros en subcategorías y limpiarlos
-        std::stringstream genreStream(genres);
-        std::string genre;
-        while (std::getline(genreStream, genre, ',')) {
-            // Eliminar espacios al inicio y al final de cada género
-            genre.erase(0, genre.find_first_not_of(" "));
-            genre.erase(genre.find_last_not_of(" ") + 1);
-
-            // Verificar si el género ya está en genresArray
-            bool exists = false;
-            for (int i = 0; i < genresArray.size(); ++i) {
-                if (genresArray[i] == genre) {
-                    exists = true;
-                    break;
-                }
-            }
-
-            // Agregar género si no existe en genresArray
-            if (!exists) {
-                genresArray.push_back(genre);
-            }
-        }
-    }
-
-    file.close();
-}
-
-
 void construirAVL() {
-    // Extraer categorías únicas
-    DynamicArray<std::string> uniqueCategories;
-    extractUniqueGenres("anime.csv", uniqueCategories);
-
-    // Crear el AVL Tree y cargar los animes
-    AVLTree<std::string, std::vector<Anime*>> categoryAVL;
-    std::vector<Anime> animes;
-    readCSV("anime.csv", animes);
+    // Cargar animes, categorías únicas y animes por categoría en una sola pasada
+    Catalog catalog;
+    loadCatalog("anime.csv", catalog);
+    const AnimeCatalog& animes = catalog.animes;
+    const std::vector<uint64_t>& genreMasks = animes.genre_masks();
+    const std::vector<float>& ratings = animes.ratings();
 
     // Construir el AVL y medir el tiempo
+    const GenreDictionary& genres = GenreDictionary::instance();
+    AVLTree<std::string, std::vector<AnimeHandle>> categoryAVL;
     auto buildTime = timeExecuation([&]() {
-        for (const auto& category : uniqueCategories) {
-            categoryAVL.insert(category, {});
-        }
-        for (auto& anime : animes) {
-            for (const auto& genre : anime.genres) {
-                categoryAVL[genre].push_back(&anime);
-            }
+        for (unsigned genre : catalog.genre_ids()) {
+            categoryAVL.insert(genres.name(genre), catalog.postings[genre]);
         }
     });
     std::cout << "Tiempo para construir el AVL: " << buildTime / 1e6 << " ms\n";
 
-    // Convertir el vector de objetos a un vector de punteros
-    std::vector<Anime*> filteredResults;
-    for (auto& anime : animes) {
-        filteredResults.push_back(&anime);
+    // Todos los animes son resultados al inicio
+    std::vector<AnimeHandle> filteredResults(animes.size());
+    for (AnimeHandle anime = 0; anime < animes.size(); ++anime) {
+        filteredResults[anime] = anime;
     }
 
-    // Inicializar las categorías disponibles
-    DynamicArray<std::string> filteredCategories = uniqueCategories;
+    // Inicializar las categorías disponibles (ids de género)
+    DynamicArray<unsigned> filteredCategories;
+    for (unsigned genre : catalog.genre_ids()) {
+        filteredCategories.push_back(genre);
+    }
 
-    std::vector<std::string> selectedCategories;
+    uint64_t selectedMask = 0; // Categorías ya seleccionadas
     while (!filteredCategories.empty()) {
         // Mostrar sólo categorías válidas
         std::cout << "\nSeleccione una categoría (teclea el número):\n";
         for (size_t i = 0; i < filteredCategories.size(); ++i) {
-            std::cout << i + 1 << ". " << filteredCategories[i] << "\t";
+            std::cout << i + 1 << ". " << genres.name(filteredCategories[i]) << "\t";
             if ((i + 1) % 4 == 0) std::cout << "\n";
         }
         std::cout << "\nO teclea 0 para terminar.\nOpción: ";
@@ -417,37 +480,31 @@ void construirAVL() {
             continue;
         }
 
-        const std::string& selectedCategory = filteredCategories[choice - 1];
-        selectedCategories.push_back(selectedCategory);
+        uint64_t selectedCategory = uint64_t(1) << filteredCategories[choice - 1];
+        selectedMask |= selectedCategory;
 
         // Filtrar los resultados basados en la categoría seleccionada
-        std::vector<Anime*> newResults;
-        for (auto* anime : filteredResults) {
-            if (std::find(anime->genres.begin(), anime->genres.end(), selectedCategory) != anime->genres.end()) {
+        std::vector<AnimeHandle> newResults;
+        uint64_t remainingMask = 0; // Géneros presentes en los resultados
+        for (AnimeHandle anime : filteredResults) {
+            if (genreMasks[anime] & selectedCategory) {
                 newResults.push_back(anime);
+                remainingMask |= genreMasks[anime];
             }
         }
         filteredResults = std::move(newResults);
 
-        // Eliminar la categoría seleccionada de las categorías disponibles
-        filteredCategories.erase(choice - 1);
-
         // Actualizar las categorías filtradas basadas en los resultados actuales
-        DynamicArray<std::string> newCategories;
-        for (const auto* anime : filteredResults) {
-            for (const auto& genre : anime->genres) {
-                if (std::find(newCategories.begin(), newCategories.end(), genre) == newCategories.end() &&
-                    std::find(selectedCategories.begin(), selectedCategories.end(), genre) == selectedCategories.end()) {
-                    newCategories.push_back(genre);
-                }
-            }
+        DynamicArray<unsigned> newCategories;
+        for (uint64_t mask = remainingMask & ~selectedMask; mask != 0; mask &= mask - 1) {
+            newCategories.push_back(static_cast<unsigned>(__builtin_ctzll(mask)));
         }
         filteredCategories = std::move(newCategories);
     }
 
     // Ordenar los resultados finales por calificación
-    std::sort(filteredResults.begin(), filteredResults.end(), [](const Anime* a, const Anime* b) {
-        return a->rating > b->rating;
+    std::sort(filteredResults.begin(), filteredResults.end(), [&ratings](AnimeHandle a, AnimeHandle b) {
+        return ratings[a] > ratings[b];
     });
 
     // Preguntar al usuario cuántos resultados desea ver
@@ -464,7 +521,7 @@ void construirAVL() {
         // Mostrar los resultados
         std::cout << "\nAnimes encontrados:\n";
         for (int i = 0; i < numResults; ++i) {
-            filteredResults[i]->display();
+            animes[filteredResults[i]].display();
         }
     } else {
         std::cout << "No se encontraron animes.\n";
@@ -473,7 +530,7 @@ void construirAVL() {
 
 void printEdges(UndirectedGraphWeight& graph) {
 	// Impresion de nodos similares 
-	std::set<std::string> names;
+	std::set<std::string_view> names;
 	std::cout << "--- Creacion de aristas ---" << std::endl;
 	for (const auto& edge : graph.edges()) {
 		std::cout << "Arco entre {" << edge.v1.name << "} y {" << edge.v2.name << "} con peso de:  " << edge.weight << std::endl;
@@ -484,8 +541,8 @@ void printEdges(UndirectedGraphWeight& graph) {
 	std::cout << "--- Adyacencia de animes ---" << std::endl;
 	for (const auto& name : names) {
 		std::cout << "Animes adyacentes a '" << name << "' son: ";
-		for (const auto& adyacent : graph.neighbors(graph.find_vertex(name))) {
-			std::cout << "{"<< adyacent.name << "} "; 
+		for (const auto& adyacent : graph.neighbors(*graph.find(name))) {
+			std::cout << "{"<< graph.vertices()[adyacent].name << "} "; 
 		}
 		std::cout << std::endl;
 	}
@@ -494,11 +551,14 @@ void printEdges(UndirectedGraphWeight& graph) {
 	return;
 }
 
-const Anime& selectStartNode(UndirectedGraphWeight& graph) {
+std::optional<VertexHandle> selectStartNode(UndirectedGraphWeight& graph) {
 	std::string name;
 	std::cout << "Escribe el nombre del anime el cual sera como nodo inicial: ";
 	std::getline(std::cin >> std::ws, name);
-	return graph.find_vertex(name);
+	std::optional<VertexHandle> start = graph.find(name);
+	if (!start)
+		std::cout << "No se encontro el anime '" << name << "'" << std::endl;
+	return start;
 }
 
 void printTrail(UndirectedGraphWeight& graph) {
@@ -510,11 +570,13 @@ void printTrail(UndirectedGraphWeight& graph) {
 		std::cin >> option;
 		switch (option) {
 			case BFS:
-				graph.print_bfs(selectStartNode(graph));
+				if (std::optional<VertexHandle> start = selectStartNode(graph))
+					graph.print_bfs(graph.vertices()[*start]);
 				std::cout << std::endl;
 				break;
 			case DFS:
-				graph.print_dfs(selectStartNode(graph));
+				if (std::optional<VertexHandle> start = selectStartNode(graph))
+					graph.print_dfs(graph.vertices()[*start]);
 				std::cout << std::endl;
 				break;
 			case EXIT:
@@ -543,9 +605,14 @@ void printPath(UndirectedGraphWeight& graph) {
 		std::getline(std::cin >> std::ws, name1);
 		std::cout << "Anime que desea encontrar si tiene relacion: ";
 		std::getline(std::cin >> std::ws, name2);
+		std::optional<VertexHandle> start = graph.find(name1), end = graph.find(name2);
+		if ((option == BFS || option == DFS) && (!start || !end)) {
+			std::cout << "No se encontro alguno de los animes" << std::endl;
+			continue;
+		}
 		switch (option) {
 			case BFS:
-				path = graph.find_path_bfs(graph.find_vertex(name1), graph.find_vertex(name2));
+				path = graph.find_path_bfs(graph.vertices()[*start], graph.vertices()[*end]);
 				std::cout << "Camino BFS: " << std::endl;
 				for (size_t i = 0; i < path.size(); i++) {
 					std::cout << path[i].name << " ";
@@ -556,7 +623,7 @@ void printPath(UndirectedGraphWeight& graph) {
 				std::cout << " --> Ponderacion: " << weight << std::endl;
 				break;
 			case DFS:
-				path = graph.find_path_dfs(graph.find_vertex(name1), graph.find_vertex(name2));
+				path = graph.find_path_dfs(graph.vertices()[*start], graph.vertices()[*end]);
 				std::cout << "Camino DFS:" << std::endl;
 				for (size_t i = 0; i < path.size(); i++) {
 					std::cout << path[i].name << " ";
@@ -587,9 +654,9 @@ void graphConstruction() {
 		std::cout << "Umbral invalido, reconfigurado a 0.8..." << std::endl;
 		threshold = 0.8;
 	}
-        auto timeNode = timeExecuation([&]{readCSV("anime.csv", graph);}); // Crea los nodos del grafo
+        auto timeNode = timeExecuation([&]{loadCatalog("anime.csv", graph);}); // Crea los nodos del grafo
         std::cout << "Tiempo de crear los nodos: " << timeNode/1e6 << " ms" << std::endl;
-	auto timeEdge = timeExecuation([&]{buildGraph(graph, threshold);}); // Crea los arcos dependiendo de la similitud de los nodos
+	auto timeEdge = timeExecuation([&]{loadGraph(graph, threshold);}); // Crea los arcos dependiendo de la similitud de los nodos (o los lee de graph.bin)
         std::cout << "Tiempo de generar las aristas de similitud entre nodos: " << timeEdge/1e6 << " ms" << std::endl;
 	do {
 		std::cout << "Desea ver los vecinos de cada anime {0: no, 1: si}: ";
@@ -620,8 +687,8 @@ void graphPaths() {
 		std::cout << "Umbral invalido, reconfigurado a 0.8..." << std::endl;
 		threshold = 0.8;
 	}
-	readCSV("anime.csv", graph); // Crea los nodos del grafo
-	buildGraph(graph, threshold); // Crea los arcos dependiendo de la similitud de los nodos
+	loadCatalog("anime.csv", graph); // Crea los nodos del grafo
+	loadGraph(graph, threshold); // Crea los arcos dependiendo de la similitud de los nodos (o los lee de graph.bin)
 	do {
 		std::cout << "Opciones disponibles: Recorridos (0), Caminos (1), Salir (2): ";
 		std::cin >> option;